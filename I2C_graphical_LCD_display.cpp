@@ -20,6 +20,26 @@
                                  -- also increased initial LCD_BUSY_DELAY from 20 to 50 uS
  Version 1.10:  8 July 2012      -- fixed issue with dropping enable before reading from display
  Version 1.11: 15 August 2014    -- added support for Print class, and an inverse mode
+ Version 1.12: 19 October 2026   -- added batched transfers (beginBatch / endBatch), strip chart widget
+                                 -- faster begin, with options to skip clearing or detect a warm restart
+                                 -- added readRegion and PBM screenshots
+                                 -- can be compiled on a Linux host, talking to an emulator (see host/)
+                                 -- print sends a whole string (or number) in one batch, added printFixed
+                                 -- added display lists (beginRecord / endRecord / render)
+                                 -- wide clears, scroll and turning on go to both chips at once
+                                 -- can draw into a frame buffer (setTarget), and send only what changed (display)
+                                 -- added writeRun, and LCD_dither for grayscale images
+                                 -- added bitmap (any y position), and LCD_bitmap.h to make them at compile time
+                                 -- added importRows and blitRows for row-by-row (1 bit per pixel) images
+                                 -- added autotune (fastest reliable I2C clock, or SPI delay), setSpeed, saveSpeed
+                                 -- bus errors are counted, and verify repairs pages they (or anything else) damaged
+                                 -- added viewports (pushViewport / pushClip / popViewport): drawing is moved and clipped
+                                 -- added measureText, and textBox: word-wrapped, aligned text, each line sent once
+                                 -- added setRotation: upside down (no extra bus traffic), or portrait frame buffers
+                                 -- added fillPattern: 8 x 8 pattern fills (greys, hatches) at the speed of clear
+                                 -- added LCD_grayscale: four grey levels by temporal dithering, at a steady frame rate
+                                 -- added LCD_damage: changed regions of a frame sent most urgent first, with deadlines
+                                 -- added LCD_animation: keyframe plus deltas in PROGMEM, and host/lcd_animation_tool
  
  
  * These changes required hardware changes to pin configurations
@@ -50,15 +70,68 @@
 
 #include "I2C_graphical_LCD_display.h"
 
-// WARNING: Put this following line into your main program or you will get compiler errors:
-#include <Wire.h>
-#include <SPI.h>
+#ifdef ARDUINO
+  // WARNING: Put this following line into your main program or you will get compiler errors:
+  #include <Wire.h>
+  #include <SPI.h>
+#endif
+
+#ifdef __AVR__
+  #include <avr/eeprom.h>
+#endif
+
+// The Wire library can only send this many bytes (including the register number) in one transaction.
+// On a host, the transport says how much it can take.
+#if !defined (ARDUINO)
+  #define LCD_I2C_BUFFER (_transport->maxTransaction ())
+#elif defined (BUFFER_LENGTH)
+  #define LCD_I2C_BUFFER BUFFER_LENGTH
+#else
+  #define LCD_I2C_BUFFER 32
+#endif
+
+// Display list operations. Each is the op byte followed by the arguments of the call.
+// Text and data are stored as runs: op, inverse flag, count, then the letters (or bytes).
+
+#define LCD_OP_GOTO   1   // x, y
+#define LCD_OP_DATA   2   // 0, count, data ... (already inverted if necessary)
+#define LCD_OP_TEXT   3   // inv, count, letters ...
+#define LCD_OP_BLIT   4   // pointer to picture (PROGMEM), size (low byte, high byte)
+#define LCD_OP_CLEAR  5   // x1, y1, x2, y2, val
+#define LCD_OP_PIXEL  6   // x, y, val
+#define LCD_OP_FILL   7   // x1, y1, x2, y2, val
+#define LCD_OP_FRAME  8   // x1, y1, x2, y2, val, width
+#define LCD_OP_LINE   9   // x1, y1, x2, y2, val
+#define LCD_OP_BITMAP 10  // pointer to picture (PROGMEM), x, y, w, h
+#define LCD_OP_PATTERN 11 // pointer to pattern (PROGMEM), x1, y1, x2, y2
 
-// SPI is so fast we need to give the LCD time to catch up.
-// This is the number of microseconds we wait. Something like 20 to 50 is probably reasonable.
-//  Increase this value if the display is either not working, or losing data.
+// autotune steps from the slowest speed up: I2C clock (Hz), or SPI delay (microseconds)
+// (the MCP23017 is good for 1.7 MHz, if the wiring is - clocks above LCD_MAX_CLOCK are skipped)
 
-#define LCD_BUSY_DELAY 50   // microseconds
+const uint32_t tuneClocks [] PROGMEM = { 100000, 200000, 300000, 400000, 600000, 800000, 1000000, 1700000 };
+const byte tuneDelays [] PROGMEM = { LCD_BUSY_DELAY, 40, 30, 20, 15, 10, 6, 3, 0 };
+
+#define LCD_TUNE_MAGIC 0x4C   // marks speed settings saved in EEPROM
+
+// fill patterns (see fillPattern) - column bytes, top row in the low bit
+// the greys are a 4 x 4 Bayer matrix: each level is the one before plus some more pixels
+
+const byte LCD_patterns [] [8] PROGMEM = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // white
+  { 0x11, 0x00, 0x44, 0x00, 0x11, 0x00, 0x44, 0x00 }, // grey 12%
+  { 0x55, 0x00, 0x55, 0x00, 0x55, 0x00, 0x55, 0x00 }, // grey 25%
+  { 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA }, // grey 50%
+  { 0x55, 0xFF, 0x55, 0xFF, 0x55, 0xFF, 0x55, 0xFF }, // grey 75%
+  { 0x77, 0xFF, 0xDD, 0xFF, 0x77, 0xFF, 0xDD, 0xFF }, // grey 87%
+  { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }, // black
+  { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11 }, // horizontal
+  { 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00 }, // vertical
+  { 0x88, 0x44, 0x22, 0x11, 0x88, 0x44, 0x22, 0x11 }, // diagonal
+  { 0x11, 0x22, 0x44, 0x88, 0x11, 0x22, 0x44, 0x88 }, // back diagonal
+  { 0xFF, 0x11, 0x11, 0x11, 0xFF, 0x11, 0x11, 0x11 }, // grid
+  { 0x99, 0x66, 0x66, 0x99, 0x99, 0x66, 0x66, 0x99 }, // crosshatch
+  { 0xF0, 0xF0, 0xF0, 0xF0, 0x0F, 0x0F, 0x0F, 0x0F }, // checker
+};
 
 // font data - each character is 8 pixels deep and 5 pixels wide
 
@@ -167,6 +240,8 @@ const byte font [96] [5] PROGMEM = {
   
 };
 
+#ifdef ARDUINO
+
 // glue routines for version 1.0+ of the IDE
 uint8_t i2c_read ()
 {
@@ -186,67 +261,231 @@ void i2c_write (int data)
 #endif
 } // end of Nunchuk::i2c_write
 
+#endif // ARDUINO
+
 
 // prepare for sending to MCP23017 
 void I2C_graphical_LCD_display::startSend ()   
 {
   
+#ifdef ARDUINO
   if (_ssPin)
     {
-    delayMicroseconds (LCD_BUSY_DELAY);
+    delayMicroseconds (_busyDelay);
     digitalWrite (_ssPin, LOW); 
     SPI.transfer (_port << 1);
     }
   else
     Wire.beginTransmission (_port);
+#else
+  _transport->startSend (_port);
+#endif
   
 }  // end of I2C_graphical_LCD_display::startSend
 
 // send a byte via SPI or I2C
 void I2C_graphical_LCD_display::doSend (const byte what)   
 {
+#ifdef ARDUINO
   if (_ssPin)
     SPI.transfer (what);
   else
     i2c_write (what);
+#else
+  _transport->doSend (what);
+#endif
 }  // end of I2C_graphical_LCD_display::doSend
 
 // finish sending to MCP23017 
 void I2C_graphical_LCD_display::endSend ()   
 {
+#ifdef ARDUINO
   if (_ssPin)
     digitalWrite (_ssPin, HIGH); 
-  else
-    Wire.endTransmission ();
+  else if (Wire.endTransmission () != 0)
+    busFault ();   // what this was writing may not have reached the LCD
+  _sending = 0;
+#else
+  byte error = _transport->endSend ();
+  if (_batchDepth == 0)
+    {
+    error |= _transport->flush ();   // eg. LCD_i2c_dev holds on to messages until told to send them
+    if (error)
+      busFault ();
+    _sending = 0;
+    }
+  else if (error)
+    busFault ();
+#endif
  
 }  // end of I2C_graphical_LCD_display::endSend
 
+// start grouping commands and data together (calls may be nested)
+// nothing is guaranteed to have reached the LCD until the matching endBatch
+void I2C_graphical_LCD_display::beginBatch ()
+{
+  _batchDepth++;
+}  // end of I2C_graphical_LCD_display::beginBatch
+
+// finish grouping - sends anything still waiting
+void I2C_graphical_LCD_display::endBatch ()
+{
+  if (_batchDepth == 1 && _runLength)
+    sendRun ();
+  if (_batchDepth && --_batchDepth == 0)
+    {
+    closeBatch ();
+#ifndef ARDUINO
+    if (_transport && _transport->flush ())   // (there isn't one if we only ever draw into a frame buffer)
+      busFault ();
+    _sending = 0;
+#endif
+    }
+}  // end of I2C_graphical_LCD_display::endBatch
+
+// finish the batch transaction in progress (if any)
+void I2C_graphical_LCD_display::closeBatch ()
+{
+  if (_batchBytes)
+    endSend ();
+  _batchBytes = 0;
+}  // end of I2C_graphical_LCD_display::closeBatch
+
+// queue one E pulse (command or data) into the current batch
+// control is what goes on port A apart from the enable line
+void I2C_graphical_LCD_display::strobe (const byte control, 
+                                        const byte data)
+{
+  
+  // no room left in the Wire buffer? send what we have so far
+  if (_batchBytes && !_ssPin && _batchBytes + 4 > LCD_I2C_BUFFER)
+    closeBatch ();
+  
+  if (_batchBytes == 0)
+    {
+    startSend ();
+    doSend (GPIOB);    // start on the data port, so the MCP23017 toggles B, A, B, A ...
+    _batchBytes = 1;
+    }
+  else if (_ssPin)
+    delayMicroseconds (_busyDelay);   // SPI is still too fast for the LCD
+  
+  // in byte mode the MCP23017 toggles between port B and port A, so the four sends do this:
+  //   1. Port B: the data (or command)
+  //   2. Port A: set E high (with D/I and chip select)
+  //   3. Port B: the same data again (we have to send something to get back to port A)
+  //   4. Port A: set E low to toggle the transfer of data
+  
+  doSend (data);
+  doSend (control | LCD_ENABLE);
+  doSend (data);
+  doSend (control);
+  _batchBytes += 4;
+  
+}  // end of I2C_graphical_LCD_display::strobe
+
+// upside down, the top of each byte is at the bottom
+static byte reverseBits (byte b)
+{
+  b = (b >> 4) | (b << 4);
+  b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+  return ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+}  // end of reverseBits
+
+// and the left-hand chip is on the right
+static byte otherChip (const byte chip)
+{
+  return ((chip & LCD_CS1) ? LCD_CS2 : 0) | ((chip & LCD_CS2) ? LCD_CS1 : 0);
+}  // end of otherChip
+
+// upside down: send the run of data writeData kept, to the other chip, from its right-hand end, 
+// each byte turned over - so what was written left to right appears right to left
+// the LCD still only needs the page and address once, so this costs the same as sending it normally
+// (except that runs longer than LCD_RUN_SIZE are sent in pieces)
+void I2C_graphical_LCD_display::sendRun ()
+{
+  byte count = _runLength;
+  if (count == 0)
+    return;
+  _runLength = 0;
+  
+  unsigned int pages = (((_runChip & LCD_CS1) ? 0x001 : 0) | ((_runChip & LCD_CS2) ? 0x100 : 0)) << _runPage;
+  byte chip = otherChip (_runChip);
+  
+  beginBatch ();
+  _sending |= pages;
+  strobe (LCD_RESET | chip, LCD_SET_PAGE | (7 - _runPage));
+  strobe (LCD_RESET | chip, LCD_SET_ADD  | (64 - _runX - count));
+  while (count--)
+    {
+    _sending |= pages;   // (each time, in case a full transaction has just gone)
+    strobe (LCD_RESET | LCD_DATA | chip, reverseBits (_run [count]));
+    }
+  endBatch ();
+}  // end of I2C_graphical_LCD_display::sendRun
+
 
 // set up - call before using
 // specify 
 //  * the port that the MCP23017 is on (default 0x20)
 //  * the i2c port (default 0)
 //  * the SPI SS (slave select) pin - leave as default of zero for I2C operation
+//  * options:
+//      LCD_BEGIN_NO_CLEAR - don't clear the display memory
+//      LCD_BEGIN_WARM     - if the MCP23017 and LCD are already set up and turned on 
+//                           (eg. our processor was reset by the watchdog, but they weren't)
+//                           then leave the display exactly as it is (no reset, no clear, no scroll)
 
 // turns LCD on, clears memory, sets the cursor to 0,0
+// returns true if a warm restart was detected (and the display left alone)
 
-// Approx time to run: 600 ms on Arduino Uno
-void I2C_graphical_LCD_display::begin (const byte port, 
-                                       const byte i2cAddress,
-                                       const byte ssPin)
+// Approx time to run: almost all of it is clearing the display, which is done in batches -
+//   about 209 ms at 100 kHz, 52 ms at 400 kHz, 26 ms at 800 kHz and 21 ms at 1 MHz (see setSpeed),
+//   so starting in under 50 ms needs a clock above about 420 kHz.
+//   With LCD_BEGIN_NO_CLEAR, or after a warm restart, it is a few ms (1.4 ms warm at 400 kHz).
+boolean I2C_graphical_LCD_display::begin (const byte port, 
+                                          const byte i2cAddress,
+                                          const byte ssPin,
+                                          const byte options)
 {
   
   _port = port;   // remember port
   _ssPin = ssPin; // and SPI slave select pin
   
+#ifdef ARDUINO
   if (_ssPin)
     SPI.begin ();
   else
     Wire.begin (i2cAddress);   
+#endif
 
-// un-comment next line for faster I2C communications:
-//   TWBR = 12;
+  // faster I2C communications: see autotune and setSpeed
+  if (_busClock)
+    setSpeed (_busClock, _busyDelay);   // (Wire.begin puts the clock back to 100 kHz)
 
+  // If the MCP23017 is still in byte mode, with port A as outputs, we set it up before, and it
+  // hasn't lost power since (after power-up IOCON is 0 and all pins are inputs).
+  // In that case, if both LCD chips say they are turned on, and not in reset, leave them alone.
+  if ((options & LCD_BEGIN_WARM) && 
+      expanderRead (IOCON) == 0b00100000 && 
+      expanderRead (IODIRA) == 0)
+    {
+    // make sure enable is low, and the data port is output
+    expanderWrite (GPIOA, LCD_RESET);
+    expanderWrite (IODIRB, 0);
+    
+    _chipSelect = LCD_CS1;
+    byte status1 = readStatus ();
+    _chipSelect = LCD_CS2;
+    byte status2 = readStatus ();
+    
+    if (((status1 | status2) & (LCD_STATUS_OFF | LCD_STATUS_RESET)) == 0)
+      {
+      gotoxy (0, 0);
+      return true;
+      }
+    }  // end of checking for warm restart
+  
   // byte mode (not sequential)
   expanderWrite (IOCON, 0b00100000);
   
@@ -264,16 +503,13 @@ void I2C_graphical_LCD_display::begin (const byte port,
   expanderWrite (GPIOA, LCD_ENABLE | LCD_RESET);
   delay (1);
   
-  // turn LCD chip 1 on
-  _chipSelect = LCD_CS1;
-  cmd (LCD_ON);
-
-  // turn LCD chip 2 on
-  _chipSelect = LCD_CS2;
+  // turn both LCD chips on (with both selected they take the command together)
+  _chipSelect = LCD_CS1 | LCD_CS2;
   cmd (LCD_ON);
   
   // clear entire LCD display
-  clear ();
+  if (!(options & LCD_BEGIN_NO_CLEAR))
+    clear ();
   
   // and put the cursor in the top-left corner
   gotoxy (0, 0);
@@ -281,13 +517,345 @@ void I2C_graphical_LCD_display::begin (const byte port,
   // ensure scroll is set to zero
   scroll (0);   
   
-}  // end of I2C_graphical_LCD_display::I2C_graphical_LCD_display (constructor)
+  return false;
+}  // end of I2C_graphical_LCD_display::begin
+
+
+// set the I2C clock (Hz, 0 = leave it alone) and the delay between SPI transfers (microseconds)
+void I2C_graphical_LCD_display::setSpeed (const unsigned long clock, 
+                                          const unsigned int busyDelay)
+{
+  _busClock = clock > LCD_MAX_CLOCK ? LCD_MAX_CLOCK : clock;
+  _busyDelay = busyDelay;
+  
+  if (_busClock == 0 || _ssPin)
+    return;
+  
+#if defined (ARDUINO) && ARDUINO >= 157
+  Wire.setClock (_busClock);
+#elif defined (TWBR)
+  TWBR = ((F_CPU / _busClock) - 16) / 2;
+#elif !defined (ARDUINO)
+  if (_transport)
+    _transport->setClock (_busClock);
+#endif
+}  // end of I2C_graphical_LCD_display::setSpeed
+
+// test pattern "pass", byte i (alternate bits, the other way around, walking bit, mixed)
+static byte tunePattern (const byte pass, 
+                         const byte i)
+{
+  switch (pass & 3)
+    {
+    case 0:  return (i & 1) ? 0xAA : 0x55;
+    case 1:  return (i & 1) ? 0x55 : 0xAA;
+    case 2:  return 1 << (i & 7);
+    default: return i * 0x1D + 0x3B;
+    }
+}  // end of tunePattern
+
+// read 8 columns either side of the chip boundary
+void I2C_graphical_LCD_display::tuneRead (const byte page, 
+                                          byte * buf)
+{
+  for (byte half = 0; half < 2; half++)
+    {
+    gotoxy (56 + half * 8, page * 8);
+    readBack (&buf [half * 8], 8);
+    }
+}  // end of I2C_graphical_LCD_display::tuneRead
+
+// write the test patterns at the current speed - true if they all read back correctly
+boolean I2C_graphical_LCD_display::tuneTest (const byte page)
+{
+  byte got [16];
+  
+  for (byte pass = 0; pass < LCD_TUNE_PASSES; pass++)
+    {
+    beginBatch ();
+    gotoxy (56, page * 8);
+    for (byte i = 0; i < 16; i++)
+      writeData (tunePattern (pass, i), false);
+    endBatch ();
+    
+    tuneRead (page, got);
+    for (byte i = 0; i < 16; i++)
+      if (got [i] != tunePattern (pass, i))
+        return false;
+    }  // end of for each pass
+  
+  return true;
+}  // end of I2C_graphical_LCD_display::tuneTest
+
+// find the fastest speed at which what we write reads back correctly, and back off one step from it
+// I2C: the clock is stepped up (Wire.setClock); SPI: the delay between transfers is stepped down
+boolean I2C_graphical_LCD_display::autotune (const byte page)
+{
+  if (_recording)
+    return false;
+  
+  // this has to be the real LCD (in screen coordinates)
+  byte oldSink = _sink;
+  byte depth = _viewportDepth;
+  byte x = cursorX ();
+  byte y = cursorY ();
+  _sink = LCD_SINK_BUS;
+  _viewportDepth = 0;
+  
+  byte steps = _ssPin ? sizeof tuneDelays : sizeof tuneClocks / sizeof tuneClocks [0];
+  if (!_ssPin)
+    while (steps > 1 && pgm_read_dword (&tuneClocks [steps - 1]) > LCD_MAX_CLOCK)
+      steps--;
+  byte step;
+  boolean ok = false;
+  byte best = 0;
+  byte saved [16];
+  
+  for (step = 0; step < steps; step++)
+    {
+    if (_ssPin)
+      setSpeed (0, pgm_read_byte (&tuneDelays [step]));
+    else
+      setSpeed (pgm_read_dword (&tuneClocks [step]), _busyDelay);
+    
+    // keep what was there, read at the slowest speed
+    if (step == 0)
+      tuneRead (page & 7, saved);
+    
+    if (!tuneTest (page & 7))
+      break;
+    ok = true;
+    best = step;
+    }  // end of for each speed
+  
+  // one step slower than the fastest which worked, whether or not a faster one failed: passing
+  // LCD_TUNE_PASSES tests doesn't mean the wiring has any margin left at that speed
+  if (best > 0)
+    best--;
+  
+  if (_ssPin)
+    setSpeed (0, pgm_read_byte (&tuneDelays [best]));
+  else
+    setSpeed (pgm_read_dword (&tuneClocks [best]), _busyDelay);
+  
+  // the failed test may have upset the expander, so set it up again
+  expanderWrite (IOCON, 0b00100000);
+  expanderWrite (IODIRA, 0);
+  expanderWrite (IODIRB, 0);
+  
+  // put back what was there (unless reading it didn't work either)
+  if (ok)
+    {
+    beginBatch ();
+    gotoxy (56, (page & 7) * 8);
+    for (byte i = 0; i < 16; i++)
+      writeData (saved [i], false);
+    endBatch ();
+    }
+  
+  _sink = oldSink;
+  gotoxy (x, y);
+  _viewportDepth = depth;
+  _placed = false;
+  
+  return ok;
+}  // end of I2C_graphical_LCD_display::autotune
+
+#ifdef __AVR__
+
+// EEPROM: magic number, clock (4 bytes), delay (2 bytes), then a checksum of those 7 bytes
+void I2C_graphical_LCD_display::saveSpeed (const int address)
+{
+  byte data [8];
+  data [0] = LCD_TUNE_MAGIC;
+  memcpy (&data [1], &_busClock, 4);
+  memcpy (&data [5], &_busyDelay, 2);
+  data [7] = 0;
+  for (byte i = 0; i < 7; i++)
+    data [7] += data [i];
+  eeprom_update_block (data, (void *) address, sizeof data);
+}  // end of I2C_graphical_LCD_display::saveSpeed
+
+boolean I2C_graphical_LCD_display::loadSpeed (const int address)
+{
+  byte data [8];
+  byte sum = 0;
+  eeprom_read_block (data, (const void *) address, sizeof data);
+  for (byte i = 0; i < 7; i++)
+    sum += data [i];
+  if (data [0] != LCD_TUNE_MAGIC || data [7] != sum)
+    return false;   // nothing saved there (or it was damaged)
+  
+  unsigned long clock;
+  unsigned int busyDelay;
+  memcpy (&clock, &data [1], 4);
+  memcpy (&busyDelay, &data [5], 2);
+  setSpeed (clock, busyDelay);
+  return true;
+}  // end of I2C_graphical_LCD_display::loadSpeed
+
+#endif // __AVR__
+
+// read "count" bytes from the LCD itself (never the cache), starting at the cursor, which must 
+// not need to move to the other chip
+void I2C_graphical_LCD_display::readBack (byte * buf, 
+                                          const byte count)
+{
+  byte chip = _chipSelect;
+  
+  // upside down: the LCD reads forwards, from the far end of what we want, on the other chip
+  if (_rotation == LCD_ROTATE_180)
+    {
+    sendRun ();
+    chip = otherChip (_chipSelect);
+    beginBatch ();
+    strobe (LCD_RESET | chip, LCD_SET_PAGE | (7 - (_lcdy >> 3)));
+    strobe (LCD_RESET | chip, LCD_SET_ADD  | (64 - _lcdx - count));
+    endBatch ();
+    }
+  
+  closeBatch ();
+  expanderWrite (IODIRB, 0xFF);   // data port is input
+  byte oldChip = _chipSelect;
+  _chipSelect = chip;
+  readRun (buf, count);
+  _chipSelect = oldChip;
+  expanderWrite (IODIRB, 0);      // and output again
+  
+  // and turn what we got round
+  if (_rotation == LCD_ROTATE_180)
+    for (byte i = 0; i < (count + 1) / 2; i++)
+      {
+      byte b = reverseBits (buf [i]);
+      buf [i] = reverseBits (buf [count - 1 - i]);
+      buf [count - 1 - i] = b;
+      }
+}  // end of I2C_graphical_LCD_display::readBack
+
+#if LCD_VERIFY_CHECKSUMS
+
+// Fletcher-16 checksum (unlike a plain sum, bytes in the wrong place change it too)
+static unsigned int fletcher16 (const byte * data, 
+                                const byte count)
+{
+  unsigned int sum1 = 0, sum2 = 0;
+  for (byte i = 0; i < count; i++)
+    {
+    sum1 = (sum1 + data [i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+    }
+  return (sum2 << 8) | sum1;
+}  // end of fletcher16
+
+#endif // LCD_VERIFY_CHECKSUMS
+
+// what "page" (n: page (n & 7) of chip (n >> 3)) should be showing - 64 bytes
+void I2C_graphical_LCD_display::intended (const byte page, 
+                                          byte * buf) const
+{
+  for (byte x = 0; x < 64; x++)
+#ifdef WRITETHROUGH_CACHE
+    buf [x] = _cache [(page >> 3) * (64 * 64 / 8) + (x << 3) + (page & 7)];
+#else
+    buf [x] = _reference [(page & 7) * 128 + (page >> 3) * 64 + x];
+#endif
+}  // end of I2C_graphical_LCD_display::intended
+
+// frame to keep up to date with what is sent to the LCD, so verify can repair it (NULL = none)
+void I2C_graphical_LCD_display::setReference (byte * frame)
+{
+  _reference = frame;
+  _checkValid = 0;
+}  // end of I2C_graphical_LCD_display::setReference
 
+// read back "count" pages (of one chip), and rewrite any which aren't what was drawn
+// suspect pages (where a transmission failed) go first, then the rest in turn
+// Approx time: reading a page is 64 short read transactions, rewriting it one batch
+byte I2C_graphical_LCD_display::verify (byte count)
+{
+#ifndef WRITETHROUGH_CACHE
+  if (_reference == NULL)
+    return 0;   // nothing to compare with
+#endif
+  if (_recording || _sink != LCD_SINK_BUS)
+    return 0;
+  
+  byte x = cursorX ();
+  byte y = cursorY ();
+  byte repaired = 0;
+  byte want [64];
+  byte got [64];
+  byte depth = _viewportDepth;
+  _viewportDepth = 0;   // (screen coordinates)
+  
+  while (count--)
+    {
+    byte page = 0;
+    if (_suspect)
+      while (!(_suspect & (1U << page)))
+        page++;
+    else
+      page = _verifyNext++ & 15;
+    unsigned int bit = 1U << page;
+    
+#if LCD_VERIFY_CHECKSUMS
+    // only work out the checksum again if something was drawn there since last time
+    if (!(_checkValid & bit))
+      {
+      intended (page, want);
+      _checksum [page] = fletcher16 (want, 64);
+      _checkValid |= bit;
+      }
+#endif
+    
+    gotoxy ((page >> 3) * 64, (page & 7) * 8);
+    readBack (got, 64);
+    _pagesChecked++;
+    _suspect &= ~bit;
+    
+#if LCD_VERIFY_CHECKSUMS
+    if (fletcher16 (got, 64) == _checksum [page])
+      continue;
+    intended (page, want);
+#else
+    intended (page, want);
+    if (memcmp (got, want, 64) == 0)
+      continue;
+#endif
+    
+    // send it again (if that fails too, the page is suspect again)
+    beginBatch ();
+    gotoxy ((page >> 3) * 64, (page & 7) * 8);
+    for (byte i = 0; i < 64; i++)
+      writeData (want [i], false);
+    endBatch ();
+    _checkValid |= bit;   // (still the same)
+    
+    _pagesRepaired++;
+    repaired++;
+    }  // end of while
+  
+  gotoxy (x, y);
+  _viewportDepth = depth;
+  _placed = false;
+  return repaired;
+}  // end of I2C_graphical_LCD_display::verify
 
 // send command to LCD display (chip 1 or 2 as in chipSelect variable)
 // for example, setting page (Y) or address (X)
 void I2C_graphical_LCD_display::cmd (const byte data)
 {
+  if (_runLength)
+    sendRun ();   // (upside down: data before it has to go first)
+  
+  _sending |= cursorPages ();
+  
+  if (_batchDepth)
+    {
+    strobe (LCD_RESET | _chipSelect, data);
+    return;
+    }
+  
   startSend ();
     doSend (GPIOA);                      // control port
     doSend (LCD_RESET | LCD_ENABLE | _chipSelect);   // set enable high (D/I is low meaning instruction) 
@@ -304,6 +872,34 @@ void I2C_graphical_LCD_display::gotoxy (byte x,
                                         byte y)
 {
   
+  if (_recording)
+    {
+    byte op [] = { LCD_OP_GOTO, x, y };
+    record (op, sizeof op);
+    return;
+    }
+  
+  // in a viewport: just remember where (the LCD is told when something it can show is written)
+  if (_viewportDepth)
+    {
+    _textX = _view.x + x;
+    _textY = _view.y + y;
+    _placed = false;
+    return;
+    }
+  
+  if (portrait ())
+    {
+    // drawing into a portrait frame buffer: 64 x 128 (see cursorY for where the pages go)
+    if (x > 63)
+      x = 0;
+    if (y > 127)
+      y = 0;
+    if (y & 8)
+      x += 64;
+    y = ((y >> 4) << 3) | (y & 7);
+    }
+  
   if (x > 127) 
     x = 0;                
   if (y > 63)  
@@ -330,9 +926,13 @@ void I2C_graphical_LCD_display::gotoxy (byte x,
   _lcdx = x;
   _lcdy = y;
   
-  // command LCD to the correct page and address
-  cmd (LCD_SET_PAGE | (y >> 3) );  // 8 pixels to a page
-  cmd (LCD_SET_ADD  | x );          
+  // command LCD to the correct page and address (not while rendering into a window)
+  // (upside down, each run of data is given its address when it is sent - see sendRun)
+  if (_sink == LCD_SINK_BUS && _rotation != LCD_ROTATE_180)
+    {
+    cmd (LCD_SET_PAGE | (y >> 3) );  // 8 pixels to a page
+    cmd (LCD_SET_ADD  | x );          
+    }
   
 #ifdef WRITETHROUGH_CACHE
   _cacheOffset += (x << 3) | y >> 3;
@@ -351,35 +951,61 @@ void I2C_graphical_LCD_display::expanderWrite (const byte reg,
   endSend ();
 } // end of I2C_graphical_LCD_display::expanderWrite
 
-// read the byte corresponding to the selected x,y position
-byte I2C_graphical_LCD_display::I2C_graphical_LCD_display::readData ()
+// read register "reg" from the expander
+byte I2C_graphical_LCD_display::expanderRead (const byte reg)
 {
+  byte data;
   
-#ifdef WRITETHROUGH_CACHE
-  return _cache [_cacheOffset];
+#ifdef ARDUINO
+  if (_ssPin)
+    {
+    delayMicroseconds (_busyDelay);
+    digitalWrite (_ssPin, LOW); 
+    SPI.transfer ((_port << 1) | 1);  // read operation has low-bit set
+    SPI.transfer (reg);               // which register to read from
+    data = SPI.transfer (0);          // get byte back
+    digitalWrite (_ssPin, HIGH); 
+    return data;
+    }
 #endif
-  
-  // data port (on the MCP23017) is now input
-  expanderWrite (IODIRB, 0xFF);
-  
-  // lol, see the KS0108 spec sheet - you need to read twice to get the data
-  startSend ();
-    doSend (GPIOA);                  // control port
-    doSend (LCD_RESET | LCD_READ | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
-  endSend ();
 
+  // select the register (the batch lets a host transport send this and the read together)
+  beginBatch ();
   startSend ();
-    doSend (GPIOA);                  // control port
-    doSend (LCD_RESET | LCD_READ | LCD_DATA | _chipSelect);  // pull enable low to toggle data 
+    doSend (reg);
   endSend ();
+  
+  data = readDataPort ();
+  endBatch ();
+  
+  return data;
+} // end of I2C_graphical_LCD_display::expanderRead
 
-  startSend ();
-  doSend (GPIOA);                  // control port
-  doSend (LCD_RESET | LCD_READ | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
-  endSend ();
+// read the status byte of the currently-selected chip (see LCD_STATUS_BUSY etc.)
+byte I2C_graphical_LCD_display::readStatus ()
+{
+  closeBatch ();
+  
+  // data port (on the MCP23017) is now input
+  expanderWrite (IODIRB, 0xFF);
+  
+  // R/W high, D/I low means status read
+  expanderWrite (GPIOA, LCD_RESET | LCD_READ | LCD_ENABLE | _chipSelect);  // set enable high 
+  byte status = expanderRead (GPIOB);
+  expanderWrite (GPIOA, LCD_RESET | LCD_READ | _chipSelect);  // pull enable low
+  
+  // data port (on the MCP23017) is now output again
+  expanderWrite (IODIRB, 0);
+  
+  return status;
+}  // end of I2C_graphical_LCD_display::readStatus
 
+// read the data port (GPIOB) - for I2C this reads whichever register the pointer is already on
+byte I2C_graphical_LCD_display::readDataPort ()
+{
   byte data;
 
+#ifdef ARDUINO
   if (_ssPin)
     {
     digitalWrite (_ssPin, LOW); 
@@ -391,67 +1017,349 @@ byte I2C_graphical_LCD_display::I2C_graphical_LCD_display::readData ()
   else
     {
     // initiate blocking read into internal buffer
-    Wire.requestFrom (_port, (byte) 1);
+    if (Wire.requestFrom (_port, (byte) 1) != 1)
+      _busErrors++;
     
     // don't bother checking if available, Wire.receive does that anyway
     //  also it returns 0x00 if nothing there, so we don't need to bother doing that
     data = i2c_read ();
     }  
+#else
+  data = _transport->requestByte (_port);
+#endif
 
-  // drop enable AFTER we have read it
-  startSend ();
-  doSend (GPIOA);                  // control port
-  doSend (LCD_RESET | LCD_READ | LCD_DATA | _chipSelect);  // pull enable low to toggle data 
-  endSend ();
-
-  // data port (on the MCP23017) is now output again
-  expanderWrite (IODIRB, 0);
-  
   return data;
-  
-}  // end of I2C_graphical_LCD_display::readData
+}  // end of I2C_graphical_LCD_display::readDataPort
 
-// write a byte to the LCD display at the selected x,y position
-// if inv true, invert the data
-// writing advances the cursor 1 pixel to the right
-// it wraps to the next "line" if necessary (a line is 8 pixels deep)
-void I2C_graphical_LCD_display::writeData (byte data, 
-                                           const boolean inv)
+// read "count" bytes from the selected chip, starting at its current address
+// the data port (on the MCP23017) must already be input
+// the LCD advances its address after each read, so we just keep toggling enable
+void I2C_graphical_LCD_display::readRun (byte * buf, 
+                                         const byte count)
 {
   
-  // invert data to be written if wanted
-  if (inv)
-    data ^= 0xFF;
-  
-  // note that the MCP23017 automatically toggles between port A and port B
-  // so the four sends do this:
-  //   1. Choose initial port as GPIOA (general IO port A)
-  //   2. Port A: set E high
-  //   3. Port B: send the data byte
-  //   4. Port A: set E low to toggle the transfer of data
-
+  // lol, see the KS0108 spec sheet - you need to read twice to get the data
+  // so: enable high, enable low (dummy read), enable high again (first byte on the data port)
+  // in byte mode each write to GPIOA is followed by one to GPIOB - which is input, so it does nothing
+  // (batched so that a host transport can send each write along with the read after it)
+  beginBatch ();
   startSend ();
     doSend (GPIOA);                  // control port
-    doSend (LCD_RESET | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
-    doSend (data);                   // (screen data written to GPIOB)
-    doSend (LCD_RESET | LCD_DATA | _chipSelect);  // (GPIOA again) pull enable low to toggle data 
-  endSend ();
-
-#ifdef WRITETHROUGH_CACHE
-  _cache [_cacheOffset] = data;
-#endif 
+    doSend (LCD_RESET | LCD_READ | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
+    doSend (0);                      // (GPIOB)
+    doSend (LCD_RESET | LCD_READ | LCD_DATA | _chipSelect);  // pull enable low to toggle data 
+    doSend (0);                      // (GPIOB)
+    doSend (LCD_RESET | LCD_READ | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
+  endSend ();  // register pointer is now on GPIOB
   
-  // we have now moved right one pixel (in the LCD hardware)
-  _lcdx++;
+  for (byte i = 0; i < count; i++)
+    {
+    buf [i] = readDataPort ();
+    
+    // drop enable AFTER we have read it (which fetches the next byte), then raise it for the next one
+    startSend ();
+      doSend (GPIOA);                  // control port
+      doSend (LCD_RESET | LCD_READ | LCD_DATA | _chipSelect);  // pull enable low to toggle data 
+      if (i < count - 1)
+        {
+        doSend (0);                    // (GPIOB)
+        doSend (LCD_RESET | LCD_READ | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
+        }
+    endSend ();
+    }  // end of for each byte
+  endBatch ();
+  
+}  // end of I2C_graphical_LCD_display::readRun
+
+// read the byte corresponding to the selected x,y position
+byte I2C_graphical_LCD_display::I2C_graphical_LCD_display::readData ()
+{
+  
+  // rendering a display list? anything outside the window is blank background
+  if (_sink == LCD_SINK_WINDOW)
+    return inWindow () ? _window [_lcdx] : 0;
+  if (_sink == LCD_SINK_FRAME)
+    return _frame [frameOffset ()];
+  
+#ifdef WRITETHROUGH_CACHE
+  return _cache [_cacheOffset];
+#endif
+  
+  // the reference (see setReference) is what the LCD should show - which may not be what it does
+  if (_reference)
+    return _reference [frameOffset ()];
+  
+  // anything batched up goes before we start reading, and the data port is input while we do
+  byte data;
+  readBack (&data, 1);
+  
+  return data;
+  
+}  // end of I2C_graphical_LCD_display::readData
+
+// read a region of the display: w columns starting at x, by "pages" pages starting at y
+// (y is forced to the nearest (lower) 8 pixels, like clear)
+// buf must have room for w * pages bytes: the first page (w bytes), then the next page, and so on
+// the data port stays input while each chip's part of a page is read, and the LCD advances the 
+// address by itself, so each byte costs two short transactions
+
+// the cursor is left at x,y
+void I2C_graphical_LCD_display::readRegion (const byte x, 
+                                            const byte y, 
+                                            const byte w, 
+                                            const byte pages, 
+                                            byte * buf)
+{
+  if (_viewportDepth)
+    {
+    // viewport coordinates: read what is on the screen there (anything off it reads as 0)
+    int sx = _view.x + x, sy = _view.y + (y & ~7);
+    int first = sx < 0 ? -sx : 0;
+    int last = sx + w > width () ? width () - 1 - sx : w - 1;
+    byte depth = _viewportDepth;
+    _viewportDepth = 0;
+    memset (buf, 0, w * pages);
+    for (byte page = 0; page < pages; page++)
+      if (first <= last && sy + page * 8 >= 0 && sy + page * 8 < height ())
+        readRegion (sx + first, sy + page * 8, last - first + 1, 1, &buf [page * w + first]);
+    _viewportDepth = depth;
+    gotoxy (x, y);
+    return;
+    }
+  
+  for (byte page = 0; page < pages; page++)
+    {
+    byte done = 0;
+    while (done < w)
+      {
+      byte col = x + done;
+      if (col >= width ())
+        break;
+      
+      // how many bytes before we reach the edge of this chip?
+      byte count = 64 - (col & 63);
+      if (count > w - done)
+        count = w - done;
+      
+      gotoxy (col, y + page * 8);
+      
+      if (_sink == LCD_SINK_FRAME)
+        memcpy (&buf [page * w + done], &_frame [frameOffset ()], count);
+      else if (_sink == LCD_SINK_BUS && _reference)
+        memcpy (&buf [page * w + done], &_reference [frameOffset ()], count);
+      else if (_sink == LCD_SINK_WINDOW)
+        {
+        for (byte i = 0; i < count; i++)
+          buf [page * w + done + i] = inWindow () ? _window [_lcdx + i] : 0;
+        }
+      else
+        {
+#ifdef WRITETHROUGH_CACHE
+        for (byte i = 0; i < count; i++)
+          buf [page * w + done + i] = _cache [_cacheOffset + i * 8];
+#else
+        readBack (&buf [page * w + done], count);
+#endif
+        }
+      
+      done += count;
+      }  // end of while
+    }  // end of for each page
+  
+  gotoxy (x, y);
+}  // end of I2C_graphical_LCD_display::readRegion
+
+// Write a PBM image (see http://netpbm.sourceforge.net/doc/pbm.html) of "pages" pages of
+// w bytes each, in LCD format (like readRegion returns) - 1 bits are black.
+// binary (P4) by default, or ascii (P1) which is easier to read on the serial monitor
+void I2C_graphical_LCD_display::writePBM (Print & out, 
+                                          const byte * buf, 
+                                          const byte w, 
+                                          const byte pages, 
+                                          const boolean ascii)
+{
+  pbmHeader (out, w, pages * 8, ascii);
+  for (byte page = 0; page < pages; page++)
+    pbmPage (out, &buf [page * w], w, ascii);
+}  // end of I2C_graphical_LCD_display::writePBM
+
+// write a PBM image of the whole display, one page at a time (so only one page is held in memory)
+void I2C_graphical_LCD_display::screenshot (Print & out, 
+                                            const boolean ascii)
+{
+  byte buf [128];
+  byte depth = _viewportDepth;
+  _viewportDepth = 0;   // all of the screen, whatever viewport is in use
+  
+  pbmHeader (out, width (), height (), ascii);
+  for (byte page = 0; page < height () / 8; page++)
+    {
+    readRegion (0, page * 8, width (), 1, buf);
+    pbmPage (out, buf, width (), ascii);
+    }
+  
+  _viewportDepth = depth;
+  _placed = false;
+}  // end of I2C_graphical_LCD_display::screenshot
+
+void I2C_graphical_LCD_display::pbmHeader (Print & out, 
+                                           const byte w, 
+                                           const byte h, 
+                                           const boolean ascii)
+{
+  out.print (ascii ? "P1\n" : "P4\n");
+  out.print (w);
+  out.print (' ');
+  out.print (h);
+  out.print ('\n');
+}  // end of I2C_graphical_LCD_display::pbmHeader
+
+// one page (8 rows of pixels)
+void I2C_graphical_LCD_display::pbmPage (Print & out, 
+                                         const byte * buf, 
+                                         const byte w, 
+                                         const boolean ascii)
+{
+  for (byte row = 0; row < 8; row++)
+    {
+    byte bits = 0;
+    for (byte x = 0; x < w; x++)
+      {
+      byte pixel = (buf [x] >> row) & 1;
+      if (ascii)
+        {
+        out.print (pixel ? '1' : '0');
+        // lines in a P1 file should be no longer than 70 characters
+        if ((x & 63) == 63 || x == w - 1)
+          out.print ('\n');
+        }
+      else
+        {
+        // binary rows are packed 8 pixels to a byte, leftmost pixel in the high-order bit
+        bits = (bits << 1) | pixel;
+        if ((x & 7) == 7 || x == w - 1)
+          {
+          out.write (bits << (7 - (x & 7)));
+          bits = 0;
+          }
+        }
+      }  // end of for each column
+    }  // end of for each row
+}  // end of I2C_graphical_LCD_display::pbmPage
+
+// write a byte to the LCD display at the selected x,y position
+// if inv true, invert the data
+// writing advances the cursor 1 pixel to the right
+// it wraps to the next "line" if necessary (a line is 8 pixels deep)
+void I2C_graphical_LCD_display::writeData (byte data, 
+                                           const boolean inv)
+{
+  
+  // invert data to be written if wanted
+  if (inv)
+    data ^= 0xFF;
+  
+  if (_recording)
+    {
+    recordRun (LCD_OP_DATA, 0, data);
+    return;
+    }
+  
+  // in a viewport: only send it if it can be seen (moving the LCD's cursor there first if need be)
+  byte depth = _viewportDepth;
+  if (depth)
+    {
+    int x = _textX++;
+    int top = _textY & ~7;
+    byte mask = clipMask (x, top);
+    if (mask == 0)
+      return;
+    
+    _viewportDepth = 0;   // what follows is in screen coordinates
+    if (mask != 0xFF)
+      {
+      // only part of the byte is inside: keep the rest as it was
+      gotoxy (x, top);
+      data = (data & mask) | (readData () & ~mask);
+      _placed = false;
+      }
+    if (!_placed || cursorX () != x || (cursorY () >> 3) != (top >> 3))
+      gotoxy (x, top);
+    _placed = true;
+    }  // end of in a viewport
+  
+  // note that the MCP23017 automatically toggles between port A and port B
+  // so the four sends do this:
+  //   1. Choose initial port as GPIOA (general IO port A)
+  //   2. Port A: set E high
+  //   3. Port B: send the data byte
+  //   4. Port A: set E low to toggle the transfer of data
+  // (when batching, strobe does much the same, but several bytes share one transaction)
+
+  if (_sink == LCD_SINK_WINDOW)
+    {
+    // rendering a display list: keep it if it is in the page we are working on
+    if (inWindow ())
+      {
+      _window [_lcdx] = data;
+      if (_lcdx < _windowFirst)
+        _windowFirst = _lcdx;
+      if (_lcdx > _windowLast)
+        _windowLast = _lcdx;
+      }
+    }
+  else if (_sink == LCD_SINK_FRAME)
+    _frame [frameOffset ()] = data;
+  else 
+    {
+    _sending |= cursorPages ();
+    _checkValid &= ~cursorPages ();
+    if (_reference)
+      _reference [frameOffset ()] = data;
+    
+    if (_rotation == LCD_ROTATE_180)
+      {
+      // upside down: keep it with the run it follows on from, to be sent backwards
+      if (_runLength && (_chipSelect != _runChip || (_lcdy >> 3) != _runPage || _lcdx != _runX + _runLength))
+        sendRun ();
+      if (_runLength == 0)
+        {
+        _runChip = _chipSelect;
+        _runPage = _lcdy >> 3;
+        _runX = _lcdx;
+        }
+      _run [_runLength++] = data;
+      if (!_batchDepth || _runLength >= LCD_RUN_SIZE)
+        sendRun ();
+      }
+    else if (_batchDepth)
+      strobe (LCD_RESET | LCD_DATA | _chipSelect, data);
+    else
+      {
+      startSend ();
+        doSend (GPIOA);                  // control port
+        doSend (LCD_RESET | LCD_DATA | LCD_ENABLE | _chipSelect);  // set enable high 
+        doSend (data);                   // (screen data written to GPIOB)
+        doSend (LCD_RESET | LCD_DATA | _chipSelect);  // (GPIOA again) pull enable low to toggle data 
+      endSend ();
+      }
+
+#ifdef WRITETHROUGH_CACHE
+    _cache [_cacheOffset] = data;
+#endif 
+    }
+  
+  // we have now moved right one pixel (in the LCD hardware)
+  _lcdx++;
 
   
   // see if we moved from chip 1 to chip 2, or wrapped at end of line
   if (_lcdx >= 64)
     {
-    if (_chipSelect == LCD_CS1)  // on chip 1, move to chip 2
+    if (_chipSelect == LCD_CS1 && !portrait ())  // on chip 1, move to chip 2
       gotoxy (64, _lcdy);
     else
-      gotoxy (0, _lcdy + 8);  // go back to chip 1, down one line
+      gotoxy (0, cursorY () + 8);  // go back to the left, down one line
     }  // if >= 64
   else
     {
@@ -460,6 +1368,7 @@ void I2C_graphical_LCD_display::writeData (byte data,
 #endif
     }
   
+  _viewportDepth = depth;
 }  // end of I2C_graphical_LCD_display::writeData
 
 
@@ -469,20 +1378,37 @@ void I2C_graphical_LCD_display::writeData (byte data,
 void I2C_graphical_LCD_display::letter (byte c, 
                                         const boolean inv)
 {
+  if (_recording)
+    {
+    recordRun (LCD_OP_TEXT, inv, c);
+    return;
+    }
+  
   if (c < 0x20 || c > 0x7F)
     c = 0x7F;  // unknown glyph
   
   c -= 0x20; // force into range of our font table (which starts at 0x20)
   
+  if (_viewportDepth)
+    {
+    // none of it inside the viewport? just move on
+    if (_textX + 5 < _view.clipX1 || _textX > _view.clipX2 || !clipPage (_textY & ~7))
+      {
+      _textX += 6;
+      return;
+      }
+    }
   // no room for a whole character? drop down a line
   // letters are 5 wide, so once we are past 59, there isn't room before we hit 63
-  if (_lcdx >= 60 && _chipSelect == LCD_CS2)
-    gotoxy (0, _lcdy + 8);
+  else if (_lcdx >= 60 && (_chipSelect == LCD_CS2 || portrait ()))
+    gotoxy (0, cursorY () + 8);
   
-  // font data is in PROGMEM memory (firmware)
+  // font data is in PROGMEM memory (firmware) - all 6 columns go in one batch
+  beginBatch ();
   for (byte x = 0; x < 5; x++)
     writeData (pgm_read_byte (&font [c] [x]), inv);
   writeData (0, inv);  // one-pixel gap between letters
+  endBatch ();
   
 }  // end of I2C_graphical_LCD_display::letter
 
@@ -491,41 +1417,695 @@ void I2C_graphical_LCD_display::string (const char * s,
                                         const boolean inv)
 {
   char c;
-  while (c = *s++)
+  beginBatch ();
+  while ((c = *s++))
     letter (c, inv); 
+  endBatch ();
 }  // end of I2C_graphical_LCD_display::string
 
+// width (in pixels) of the widest line of s
+unsigned int I2C_graphical_LCD_display::measureText (const char * s)
+{
+  unsigned int widest = 0, chars = 0;
+  char c;
+  while ((c = *s++))
+    {
+    if (c == '\n')
+      chars = 0;
+    else if (++chars > widest)
+      widest = chars;
+    }
+  return widest * 6;
+}  // end of I2C_graphical_LCD_display::measureText
+
+// find where the line starting at s ends, if lines can be "chars" letters long
+// count is set to the letters on the line (trailing spaces dropped), wrapped to true if
+// the line was broken to fit (rather than ending at '\n' or the end of the text)
+// returns where the next line starts
+const char * I2C_graphical_LCD_display::wrapLine (const char * s,
+                                                  const byte chars,
+                                                  byte & count,
+                                                  boolean & wrapped)
+{
+  const char * p = s;
+  const char * space = NULL;   // last space the line could be broken at
+  while (*p && *p != '\n' && p - s < chars)
+    {
+    if (*p == ' ' && p > s)
+      space = p;
+    p++;
+    }
+
+  const char * end = p;
+  wrapped = *p && *p != '\n';
+  if (!wrapped)
+    {
+    if (*p)
+      p++;   // past the '\n'
+    }
+  else if (*p != ' ' && space)
+    end = p = space;   // break after the last whole word (otherwise the word doesn't fit, so split it)
+
+  if (wrapped)
+    {
+    // the spaces we broke at aren't shown at the start of the next line (nor a '\n' just after them)
+    while (*p == ' ')
+      p++;
+    if (*p == '\n')
+      p++;
+    }
+
+  while (end > s && end [-1] == ' ')
+    end--;
+  count = end - s;
+  return p;
+}  // end of I2C_graphical_LCD_display::wrapLine
+
+// lines needed for s, word-wrapped to w pixels
+byte I2C_graphical_LCD_display::textLines (const char * s,
+                                           const byte w)
+{
+  byte chars = w / 6, count, lines = 0;
+  boolean wrapped;
+  if (chars == 0)
+    return 0;
+  while (*s && lines < 255)
+    {
+    s = wrapLine (s, chars, count, wrapped);
+    lines++;
+    }
+  return lines;
+}  // end of I2C_graphical_LCD_display::textLines
+
+// word-wrap s into the box, aligned, each line sent once (in one batch) in its final position
+unsigned int I2C_graphical_LCD_display::textBox (const byte x,
+                                                 const byte y,
+                                                 byte w,
+                                                 const byte h,
+                                                 const char * s,
+                                                 const byte align)
+{
+  const char * start = s;
+  byte top = y & ~7;
+  byte lines = h / 8;
+
+  // on the screen, keep every letter clear of the right-hand side (where letter would drop down a line)
+  if (!_viewportDepth)
+    {
+    if (x >= width () || top >= height ())
+      return 0;
+    if (w > width () - x)
+      w = width () - x;
+    if (lines > (height () - top) / 8)
+      lines = (height () - top) / 8;
+    }
+  else if (w > 256 - x)
+    w = 256 - x;
+
+  byte chars = w / 6;
+  if (chars == 0 || lines == 0)
+    return 0;
+
+  byte line;
+  for (line = 0; line < lines && *s; line++)
+    {
+    byte count;
+    boolean wrapped;
+    const char * next = wrapLine (s, chars, count, wrapped);
+
+    byte spare = w - count * 6;
+    byte left = 0;
+    if (align == LCD_ALIGN_RIGHT)
+      left = spare;
+    else if (align == LCD_ALIGN_CENTRE)
+      left = spare / 2;
+
+    // justified: share the spare pixels between the spaces (more for the earlier ones)
+    byte gaps = 0;
+    if (align == LCD_ALIGN_JUSTIFY && wrapped)
+      for (byte i = 0; i < count; i++)
+        if (s [i] == ' ')
+          gaps++;
+
+    beginBatch ();
+    gotoxy (x, top + line * 8);
+    byte done = left;
+    while (left--)
+      writeData (0);
+    byte gap = 0;
+    for (byte i = 0; i < count; i++)
+      {
+      letter (s [i]);
+      done += 6;
+      if (gaps && s [i] == ' ')
+        {
+        byte extra = spare / gaps + (gap++ < spare % gaps ? 1 : 0);
+        done += extra;
+        while (extra--)
+          writeData (0);
+        }
+      }  // end of for each letter
+    while (done++ < w)
+      writeData (0);
+    endBatch ();
+
+    s = next;
+    }  // end of for each line
+
+  // blank the rest of the box
+  if (line < lines)
+    clear (x, top + line * 8, x + w - 1, top + lines * 8 - 1);   // (inverted too, in inverse mode)
+
+  return s - start;
+}  // end of I2C_graphical_LCD_display::textBox
+
+#if !defined(ARDUINO) || ARDUINO >= 100
+
+// Print calls this for strings: send all the letters in one batch
+size_t I2C_graphical_LCD_display::write (const uint8_t * buffer, 
+                                         size_t size)
+{
+  size_t n = size;
+  beginBatch ();
+  while (size--)
+    letter (*buffer++, _invmode);
+  endBatch ();
+  return n;
+}  // end of I2C_graphical_LCD_display::write
+
+// write a number in decimal, with a decimal point "decimals" digits from the right
+// the digits are worked out from the left, so no buffer is needed
+size_t I2C_graphical_LCD_display::printNumber (unsigned long n, 
+                                               const boolean negative, 
+                                               byte decimals)
+{
+  if (decimals > 9)
+    decimals = 9;
+  
+  // find the value of the first digit (always at least one digit before the point)
+  unsigned long divisor = 1;
+  byte digits = 1;
+  while (n / divisor >= 10 || digits <= decimals)
+    {
+    divisor *= 10;
+    digits++;
+    }
+  
+  size_t count = digits + (decimals ? 1 : 0) + (negative ? 1 : 0);
+  
+  beginBatch ();
+  if (negative)
+    letter ('-');
+  for ( ; digits; digits--)
+    {
+    if (digits == decimals)
+      letter ('.');
+    letter ('0' + n / divisor);
+    n %= divisor;
+    divisor /= 10;
+    }
+  endBatch ();
+  
+  return count;
+}  // end of I2C_graphical_LCD_display::printNumber
+
+size_t I2C_graphical_LCD_display::print (long n, 
+                                         int base)
+{
+  if (base != DEC)
+    return Print::print (n, base);
+  return printNumber (n < 0 ? - (unsigned long) n : n, n < 0, 0);
+}  // end of I2C_graphical_LCD_display::print
+
+size_t I2C_graphical_LCD_display::print (unsigned long n, 
+                                         int base)
+{
+  if (base != DEC)
+    return Print::print (n, base);
+  return printNumber (n, false, 0);
+}  // end of I2C_graphical_LCD_display::print
+
+// Print does floats a piece at a time - at least send them together
+size_t I2C_graphical_LCD_display::print (double n, 
+                                         int digits)
+{
+  beginBatch ();
+  size_t count = Print::print (n, digits);
+  endBatch ();
+  return count;
+}  // end of I2C_graphical_LCD_display::print
+
+size_t I2C_graphical_LCD_display::printFixed (long n, 
+                                              const byte decimals)
+{
+  return printNumber (n < 0 ? - (unsigned long) n : n, n < 0, decimals);
+}  // end of I2C_graphical_LCD_display::printFixed
+
+#endif // Arduino 1.0+ or host
+
 // blits (copies) a series of bytes to the LCD display from an array in PROGMEM
 
 // Approx time to run: 2 ms/byte on Arduino Uno
 void I2C_graphical_LCD_display::blit (const byte * pic, 
                                       const unsigned int size)
 {
+  if (_recording)
+    {
+    // just remember where the picture is (so it must not move - PROGMEM won't)
+    byte op [1 + sizeof pic + 2];
+    op [0] = LCD_OP_BLIT;
+    memcpy (&op [1], &pic, sizeof pic);
+    op [1 + sizeof pic] = size & 0xFF;
+    op [2 + sizeof pic] = size >> 8;
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (_viewportDepth)
+    {
+    // only look at the part inside the viewport (if any)
+    long first = _view.clipX1 - _textX;
+    long last = _view.clipX2 - _textX;
+    if (first < 0)
+      first = 0;
+    if (last >= (long) size)
+      last = (long) size - 1;
+    if (first > last || !clipPage (_textY & ~7))
+      {
+      _textX += size;
+      return;
+      }
+    _textX += first;
+    for (unsigned int x = first; x <= last; x++)
+      writeData (pgm_read_byte (&pic [x]));
+    _textX += size - 1 - last;
+    return;
+    }
+  
   for (unsigned int x = 0; x < size; x++, pic++)
     writeData (pgm_read_byte (pic));
 }  // end of I2C_graphical_LCD_display::blit
 
+// writes a series of bytes from RAM (eg. one page of an image worked out on the fly), in one batch
+void I2C_graphical_LCD_display::writeRun (const byte * data, 
+                                          const unsigned int size)
+{
+  beginBatch ();
+  for (unsigned int x = 0; x < size; x++)
+    writeData (data [x]);
+  endBatch ();
+}  // end of I2C_graphical_LCD_display::writeRun
+
+// draws a bitmap w pixels wide and h high (from PROGMEM) with its top-left corner at x,y
+// the bitmap is in pages, like the LCD: ((h + 7) / 8) * w bytes, first page first (see LCD_bitmap.h)
+// y can be anything - if the bitmap doesn't cover a whole page of the LCD, the pixels it doesn't
+// cover are read back first (all at once, with readRegion) so they are left alone
+// the cursor is left after the last byte written
+void I2C_graphical_LCD_display::bitmap (const byte x, 
+                                        const byte y, 
+                                        const byte * pic, 
+                                        byte w, 
+                                        const byte h)
+{
+  if (_recording)
+    {
+    byte op [1 + sizeof pic + 4];
+    op [0] = LCD_OP_BITMAP;
+    memcpy (&op [1], &pic, sizeof pic);
+    op [1 + sizeof pic] = x;
+    op [2 + sizeof pic] = y;
+    op [3 + sizeof pic] = w;
+    op [4 + sizeof pic] = h;
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (x >= width () || y >= height () || w == 0 || h == 0)
+    return;
+  
+  const byte stride = w;       // bytes in each page of the bitmap
+  const byte pages = (h + 7) >> 3;
+  const byte shift = y & 7;    // how far down the page the bitmap starts
+  const int bottom = y + h;    // first row below the bitmap
+  if (w > width () - x)
+    w = width () - x;          // clip at the right-hand side
+  
+  byte old [128];
+  byte inv = _invmode ? 0xFF : 0;
+  
+  beginBatch ();
+  for (byte page = y >> 3; page < height () / 8 && page * 8 < bottom; page++)
+    {
+    // which rows in this page belong to the bitmap?
+    byte mask = 0xFF;
+    if (page * 8 < y)
+      mask &= 0xFF << shift;
+    if (page * 8 + 8 > bottom)
+      mask &= 0xFF >> (page * 8 + 8 - bottom);
+    
+    if (mask != 0xFF)
+      readRegion (x, page * 8, w, 1, old);
+    
+    // the bitmap's pages are "shift" rows further down, so each LCD page takes the bottom of one 
+    // bitmap page and the top of the next
+    int source = page - (y >> 3);   // bitmap page which goes at the bottom of this one
+    gotoxy (x, page * 8);
+    for (byte i = 0; i < w; i++)
+      {
+      byte data = 0;
+      if (source < pages)
+        data = pgm_read_byte (&pic [source * stride + i]) << shift;
+      if (shift && source > 0)
+        data |= pgm_read_byte (&pic [(source - 1) * stride + i]) >> (8 - shift);
+      data = ((data ^ inv) & mask) | (mask == 0xFF ? 0 : old [i] & ~mask);
+      writeData (data, false);
+      }  // end of for each column
+    }  // end of for each page
+  endBatch ();
+  
+}  // end of I2C_graphical_LCD_display::bitmap
+
+// turn 8 rows of 8 pixels (leftmost in the high bit) into 8 column bytes (top in the low bit)
+// (LCD_TRANSPOSE_BY_SHIFTING picks the AVR version anywhere: the host tests use it to check both)
+#if defined (__AVR__) || defined (LCD_TRANSPOSE_BY_SHIFTING)
+
+// AVR: no barrel shifter, so shifting by a variable amount means a loop - instead each row
+// shifts its leftmost pixel out, and a fixed test of the high bit puts it into the column
+void I2C_graphical_LCD_display::transpose8 (const byte * rows, 
+                                            byte * columns)
+{
+  byte r0 = rows [0], r1 = rows [1], r2 = rows [2], r3 = rows [3],
+       r4 = rows [4], r5 = rows [5], r6 = rows [6], r7 = rows [7];
+  
+  for (byte c = 0; c < 8; c++)
+    {
+    byte column = 0;
+    if (r0 & 0x80) column |= 0x01;
+    if (r1 & 0x80) column |= 0x02;
+    if (r2 & 0x80) column |= 0x04;
+    if (r3 & 0x80) column |= 0x08;
+    if (r4 & 0x80) column |= 0x10;
+    if (r5 & 0x80) column |= 0x20;
+    if (r6 & 0x80) column |= 0x40;
+    if (r7 & 0x80) column |= 0x80;
+    columns [c] = column;
+    r0 <<= 1; r1 <<= 1; r2 <<= 1; r3 <<= 1;
+    r4 <<= 1; r5 <<= 1; r6 <<= 1; r7 <<= 1;
+    }  // end of for each column
+}  // end of I2C_graphical_LCD_display::transpose8
+
+#else
+
+// 32 or 64-bit processors: the whole 8 x 8 block in one 64-bit word, transposed by swapping
+// 2 x 2, then 4 x 4 blocks of bits within it (see "Hacker's Delight", section 7-3)
+void I2C_graphical_LCD_display::transpose8 (const byte * rows, 
+                                            byte * columns)
+{
+  uint64_t x = 0, t;
+  for (byte r = 0; r < 8; r++)
+    x |= (uint64_t) rows [r] << (8 * r);
+  
+  t = (x ^ (x >> 7))  & 0x00AA00AA00AA00AAULL;  x ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;  x ^= t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;  x ^= t ^ (t << 28);
+  
+  // byte n now holds bit n of every row - that is column 7 - n
+  for (byte c = 0; c < 8; c++)
+    columns [c] = x >> (8 * (7 - c));
+}  // end of I2C_graphical_LCD_display::transpose8
+
+#endif
+
+// convert "count" rows (up to 8) of a row-by-row image into w column bytes (one page)
+void I2C_graphical_LCD_display::importRows (const byte * rows, 
+                                            const unsigned int stride, 
+                                            const byte w, 
+                                            byte * page, 
+                                            const byte count)
+{
+  byte block [8];
+  byte columns [8];
+  
+  for (byte x = 0; x < w; x += 8)
+    {
+    for (byte r = 0; r < 8; r++)
+      block [r] = r < count ? rows [r * stride + (x >> 3)] : 0;
+    
+    if (w - x >= 8)
+      transpose8 (block, &page [x]);
+    else
+      {
+      // last few columns
+      transpose8 (block, columns);
+      memcpy (&page [x], columns, w - x);
+      }
+    }  // end of for each block of 8 columns
+}  // end of I2C_graphical_LCD_display::importRows
+
+// draw a row-by-row image, w by h pixels, a page (in one batch) at a time
+void I2C_graphical_LCD_display::blitRows (const byte x, 
+                                          const byte y, 
+                                          const byte * rows, 
+                                          const unsigned int stride, 
+                                          byte w, 
+                                          const byte h)
+{
+  byte page [128];
+  
+  if (x >= width ())
+    return;
+  if (w > width () - x)
+    w = width () - x;   // clip at the right-hand side
+  
+  beginBatch ();
+  for (int row = 0; row < h && (y & ~7) + row < height (); row += 8)
+    {
+    importRows (&rows [row * stride], stride, w, page, h - row < 8 ? h - row : 8);
+    gotoxy (x, (y & ~7) + row);
+    writeRun (page, w);
+    }  // end of for each page
+  endBatch ();
+}  // end of I2C_graphical_LCD_display::blitRows
+
 // clear rectangle x1,y1,x2,y2 (inclusive) to val (eg. 0x00 for black, 0xFF for white)
 // default is entire screen to black
 // rectangle is forced to nearest (lower) 8 pixels vertically
 // this if faster than lcd_fill_rect because it doesn't read from the display
 
 // Approx time to run: 120 ms on Arduino Uno for 20 x 50 pixel rectangle
+//   (before batching - it should now be well under half that)
 void I2C_graphical_LCD_display::clear (const byte x1,    // start pixel
                                        const byte y1,     
-                                       const byte x2,  // end pixel
-                                       const byte y2,   
+                                       byte x2,        // end pixel
+                                       byte y2,   
                                        const byte val)   // what to fill with 
 {
+  if (_recording)
+    {
+    byte op [] = { LCD_OP_CLEAR, x1, y1, x2, y2, val };
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (_viewportDepth)
+    {
+    clipClear (x1, y1, x2, y2, val);
+    return;
+    }
+  
+  toEdge (x2, y2);
+  beginBatch ();
   for (byte y = y1; y <= y2; y += 8)
+    fillRow (y >> 3, x1, x2, val);
+  
+  gotoxy (x1, y1);
+  endBatch ();
+} // end of I2C_graphical_LCD_display::clear
+
+// columns x1 to x2 (inclusive) of one page to val - or, if pattern is not NULL, to the pattern
+// (8 column bytes in PROGMEM, repeated every 8 columns of the screen)
+void I2C_graphical_LCD_display::fillRow (const byte page, 
+                                         byte x1, 
+                                         byte x2, 
+                                         const byte val, 
+                                         const byte * pattern)
+{
+  // 65 or more columns wide? then x1 to x2 - 64 are on both chips: do them together, 
+  // then what is left on the right of chip 1 and the left of chip 2 (one run, as it wraps)
+  // (64 is a multiple of 8, so both chips get the same pattern bytes too)
+  if (x2 - x1 >= 64 && _sink == LCD_SINK_BUS)
+    {
+    fillBoth (page, x1, x2 - 64, val, pattern);
+    if (x2 - x1 == 127)
+      return;
+    byte from = x2 - 63;
+    x2 = x1 + 63;
+    x1 = from;
+    }
+  
+  gotoxy (x1, page * 8);
+  for (byte x = x1; x <= x2; x++)
+    writeData (pattern ? pgm_read_byte (&pattern [x & 7]) : val);
+}  // end of I2C_graphical_LCD_display::fillRow
+
+// fill x1,y1 to x2,y2 (inclusive) with an 8 x 8 pattern (8 column bytes in PROGMEM, top row in 
+// the low bit - eg. LCD_PATTERN_GREY50). The pattern is lined up with the screen, not the 
+// rectangle, so each byte is just the pattern byte for its column: pages wholly inside go out 
+// like clear (both chips at once, if wide enough); the top and bottom pages, if only partly 
+// inside, are read first (all at once, with readRegion) and the rows outside left alone.
+// the cursor is left at x1,y1
+void I2C_graphical_LCD_display::fillPattern (const byte x1, 
+                                             const byte y1, 
+                                             byte x2, 
+                                             byte y2, 
+                                             const byte * pattern)
+{
+  if (_recording)
+    {
+    byte op [1 + sizeof pattern + 4];
+    op [0] = LCD_OP_PATTERN;
+    memcpy (&op [1], &pattern, sizeof pattern);
+    op [1 + sizeof pattern] = x1;
+    op [2 + sizeof pattern] = y1;
+    op [3 + sizeof pattern] = x2;
+    op [4 + sizeof pattern] = y2;
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (_viewportDepth)
+    {
+    // just the part inside the viewport (the pattern still lines up with the screen)
+    int left = x1, top = y1, right = x2, bottom = y2;
+    clipRect (left, top, right, bottom);
+    if (left > right || top > bottom)
+      return;
+    byte depth = _viewportDepth;
+    _viewportDepth = 0;
+    fillPattern (left, top, right, bottom, pattern);
+    _viewportDepth = depth;
+    _placed = false;
+    return;
+    }
+  
+  toEdge (x2, y2);
+  if (x1 > x2 || y1 > y2)
+    return;
+  
+  byte old [128];
+  byte inv = _invmode ? 0xFF : 0;
+  
+  beginBatch ();
+  for (byte page = y1 >> 3; page <= y2 >> 3; page++)
     {
-    gotoxy (x1, y);
+    // which rows in this page are inside?
+    byte mask = 0xFF;
+    if (page == y1 >> 3)
+      mask &= 0xFF << (y1 & 7);
+    if (page == y2 >> 3)
+      mask &= 0xFF >> (7 - (y2 & 7));
+    
+    if (mask == 0xFF)
+      {
+      fillRow (page, x1, x2, 0, pattern);
+      continue;
+      }
+    
+    readRegion (x1, page * 8, x2 - x1 + 1, 1, old);
+    gotoxy (x1, page * 8);
     for (byte x = x1; x <= x2; x++)
-      writeData (val);
-    } // end of for y
+      writeData (((pgm_read_byte (&pattern [x & 7]) ^ inv) & mask) | (old [x - x1] & ~mask), false);
+    }  // end of for each page
   
   gotoxy (x1, y1);
-} // end of I2C_graphical_LCD_display::clear
+  endBatch ();
+}  // end of I2C_graphical_LCD_display::fillPattern
+
+// clear, in a viewport: the same whole pages, but only what is inside the viewport
+// (in pages only partly inside, the rows outside are read first, and left as they were)
+void I2C_graphical_LCD_display::clipClear (const byte x1, 
+                                           const byte y1, 
+                                           const byte x2, 
+                                           const byte y2, 
+                                           const byte val)
+{
+  int left = x1, top = y1 & ~7, right = x2, bottom = y2 | 7;
+  clipRect (left, top, right, bottom);
+  
+  byte depth = _viewportDepth;
+  _viewportDepth = 0;   // what follows is in screen coordinates
+  
+  beginBatch ();
+  for (int page = top & ~7; page <= bottom && left <= right; page += 8)
+    {
+    byte mask = 0xFF;
+    if (page < top)
+      mask <<= top - page;
+    if (page + 7 > bottom)
+      mask >>= page + 7 - bottom;
+    
+    if (mask == 0xFF)
+      {
+      clear (left, page, right, page, val);
+      continue;
+      }
+    
+    byte old [128];
+    byte w = right - left + 1;
+    byte data = _invmode ? val ^ 0xFF : val;
+    readRegion (left, page, w, 1, old);
+    gotoxy (left, page);
+    for (byte i = 0; i < w; i++)
+      writeData ((data & mask) | (old [i] & ~mask), false);
+    }  // end of for each page
+  endBatch ();
+  
+  _viewportDepth = depth;
+  gotoxy (x1, y1);
+}  // end of I2C_graphical_LCD_display::clipClear
+
+// write val (or, if pattern is not NULL, the pattern byte for each column) to columns from..to 
+// (0 to 63) of a page, on both chips at once
+// afterwards the cursor is not known - use gotoxy
+void I2C_graphical_LCD_display::fillBoth (const byte page, 
+                                          const byte from, 
+                                          const byte to, 
+                                          const byte val, 
+                                          const byte * pattern)
+{
+  byte inv = _invmode ? 0xFF : 0;   // as writeData would
+  
+  // upside down, the same columns of both chips are still on both chips - but sent right to left
+  boolean flip = _rotation == LCD_ROTATE_180;
+  
+  beginBatch ();
+  _chipSelect = LCD_CS1 | LCD_CS2;
+  _sending |= 0x101 << page;
+  _checkValid &= ~(0x101 << page);
+  if (flip)
+    {
+    cmd (LCD_SET_PAGE | (7 - page));
+    cmd (LCD_SET_ADD  | (63 - to));
+    }
+  else
+    {
+    cmd (LCD_SET_PAGE | page);
+    cmd (LCD_SET_ADD  | from);
+    }
+  for (byte i = 0; i <= to - from; i++)
+    {
+    byte x = flip ? to - i : from + i;
+    byte data = (pattern ? pgm_read_byte (&pattern [x & 7]) : val) ^ inv;
+    if (_reference)
+      _reference [page * 128 + x] = _reference [page * 128 + 64 + x] = data;
+    strobe (LCD_RESET | LCD_DATA | _chipSelect, flip ? reverseBits (data) : data);
+#ifdef WRITETHROUGH_CACHE
+    _cache [(x << 3) | page] = data;
+    _cache [64 * 64 / 8 + ((x << 3) | page)] = data;
+#endif 
+    }
+  endBatch ();
+}  // end of I2C_graphical_LCD_display::fillBoth
 
 // set or clear a pixel at x,y
 // warning: this is slow because we have to read the existing pixel in from the LCD display
@@ -534,6 +2114,26 @@ void I2C_graphical_LCD_display::setPixel (const byte x,
                                           const byte y, 
                                           const byte val)
 {
+  if (_recording)
+    {
+    byte op [] = { LCD_OP_PIXEL, x, y, val };
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (_viewportDepth)
+    {
+    int sx = _view.x + x, sy = _view.y + y;
+    if (sx < _view.clipX1 || sx > _view.clipX2 || sy < _view.clipY1 || sy > _view.clipY2)
+      return;   // can't be seen
+    byte depth = _viewportDepth;
+    _viewportDepth = 0;
+    setPixel (sx, sy, val);
+    _viewportDepth = depth;
+    _placed = false;
+    return;
+    }
+  
   // select appropriate page and byte
   gotoxy (x, y);
   
@@ -562,10 +2162,33 @@ void I2C_graphical_LCD_display::setPixel (const byte x,
 //    (Yep, that's over 5 seconds!)
 void I2C_graphical_LCD_display::fillRect (const byte x1, // start pixel
                                           const byte y1,     
-                                          const byte x2, // end pixel
-                                          const byte y2,    
+                                          byte x2,       // end pixel
+                                          byte y2,    
                                           const byte val)  // what to draw (0 = white, 1 = black) 
 {
+  if (_recording)
+    {
+    byte op [] = { LCD_OP_FILL, x1, y1, x2, y2, val };
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (_viewportDepth)
+    {
+    // just the part inside the viewport
+    int left = x1, top = y1, right = x2, bottom = y2;
+    clipRect (left, top, right, bottom);
+    if (left > right || top > bottom)
+      return;
+    byte depth = _viewportDepth;
+    _viewportDepth = 0;
+    fillRect (left, top, right, bottom, val);
+    _viewportDepth = depth;
+    _placed = false;
+    return;
+    }
+  
+  toEdge (x2, y2);
   for (byte y = y1; y <= y2; y++)
     for (byte x = x1; x <= x2; x++)
       setPixel (x, y, val);
@@ -578,11 +2201,29 @@ void I2C_graphical_LCD_display::fillRect (const byte x1, // start pixel
 //             1430 ms on Arduino Uno for 20 x 50 pixel rectangle with 2-pixel wide border
 void I2C_graphical_LCD_display::frameRect (const byte x1, // start pixel
                                            const byte y1,     
-                                           const byte x2, // end pixel
-                                           const byte y2,    
+                                           byte x2,       // end pixel
+                                           byte y2,    
                                            const byte val,    // what to draw (0 = white, 1 = black) 
                                            const byte width)
 {
+  if (_recording)
+    {
+    byte op [] = { LCD_OP_FRAME, x1, y1, x2, y2, val, width };
+    record (op, sizeof op);
+    return;
+    }
+  
+  if (_viewportDepth)
+    {
+    // the same pixels as below, as four rectangles, each clipped to the viewport
+    fillRect (x1, y1, x2, y1 + width - 1, val);
+    fillRect (x1, y2 - width + 1, x2, y2, val);
+    fillRect (x1, y1, x1 + width - 1, y2, val);
+    fillRect (x2 - width + 1, y1, x2, y2, val);
+    return;
+    }
+  
+  toEdge (x2, y2);
   byte x, y, i;
   
   // top line
@@ -615,6 +2256,24 @@ void I2C_graphical_LCD_display::line  (const byte x1,  // start pixel
                                        const byte y2,   
                                        const byte val)  // what to draw (0 = white, 1 = black) 
 {
+  if (_recording)
+    {
+    byte op [] = { LCD_OP_LINE, x1, y1, x2, y2, val };
+    record (op, sizeof op);
+    return;
+    }
+  
+  // in a viewport: setPixel leaves out the pixels which can't be seen, but don't even
+  // work them out if none of them can
+  if (_viewportDepth)
+    {
+    int left = x1 < x2 ? x1 : x2, top = y1 < y2 ? y1 : y2;
+    int right = x1 < x2 ? x2 : x1, bottom = y1 < y2 ? y2 : y1;
+    clipRect (left, top, right, bottom);
+    if (left > right || top > bottom)
+      return;
+    }
+  
   byte x, y;
   
   // vertical line? do quick way
@@ -674,9 +2333,505 @@ void I2C_graphical_LCD_display::line  (const byte x1,  // start pixel
 void I2C_graphical_LCD_display::scroll (const byte y)   // set scroll position
 {
   byte old_cs = _chipSelect;
-  _chipSelect = LCD_CS1;
-  cmd (LCD_DISP_START | (y & 0x3F) );  // set scroll position
-  _chipSelect = LCD_CS2;
-  cmd (LCD_DISP_START | (y & 0x3F) );  // set scroll position
+  _chipSelect = LCD_CS1 | LCD_CS2;     // both chips at once
+  if (_rotation == LCD_ROTATE_180)
+    cmd (LCD_DISP_START | ((64 - y) & 0x3F) );  // upside down, the picture goes the other way
+  else
+    cmd (LCD_DISP_START | (y & 0x3F) );  // set scroll position
   _chipSelect = old_cs;
 } // end of I2C_graphical_LCD_display::scroll
+
+// LCD_ROTATE_0, LCD_ROTATE_90, LCD_ROTATE_180 or LCD_ROTATE_270 (see the header)
+// what is on the LCD already stays as it is - redraw it (or clear it) afterwards
+void I2C_graphical_LCD_display::setRotation (const byte rotation)
+{
+  sendRun ();   // anything waiting goes the way it was drawn
+  _rotation = rotation & 3;
+  gotoxy (0, 0);
+}  // end of I2C_graphical_LCD_display::setRotation
+
+// start drawing in a viewport: the origin moves to x,y (relative to the viewport in use, if any)
+// and nothing outside w x h pixels from there, or outside the viewport in use, is drawn
+boolean I2C_graphical_LCD_display::pushViewport (const int x, 
+                                                 const int y, 
+                                                 const byte w, 
+                                                 const byte h)
+{
+  if (!pushClip (x, y, x + w - 1, y + h - 1))
+    return false;
+  _view.x += x;
+  _view.y += y;
+  return true;
+}  // end of I2C_graphical_LCD_display::pushViewport
+
+// clip drawing to x1,y1,x2,y2 (inclusive, relative to the origin), as well as the viewport in use
+boolean I2C_graphical_LCD_display::pushClip (const int x1, 
+                                             const int y1, 
+                                             const int x2, 
+                                             const int y2)
+{
+#if LCD_VIEWPORT_DEPTH == 0
+  return false;
+#else
+  if (_viewportDepth >= LCD_VIEWPORT_DEPTH)
+    return false;
+  
+  // the first one: start with the whole screen, and the cursor where the LCD has it
+  if (_viewportDepth == 0)
+    {
+    _view.x = 0;
+    _view.y = 0;
+    _view.clipX1 = 0;
+    _view.clipY1 = 0;
+    _view.clipX2 = width () - 1;
+    _view.clipY2 = height () - 1;
+    _textX = cursorX ();
+    _textY = cursorY ();
+    _placed = false;
+    }
+#if LCD_VIEWPORT_DEPTH > 1
+  else
+    _viewports [_viewportDepth - 1] = _view;
+#endif
+  
+  _viewportDepth++;
+  clipTo (_view.x + x1, _view.y + y1, _view.x + x2, _view.y + y2);
+  return true;
+#endif
+}  // end of I2C_graphical_LCD_display::pushClip
+
+// back to the viewport before - after the last one, the LCD's cursor is put where ours was
+void I2C_graphical_LCD_display::popViewport ()
+{
+  if (_viewportDepth == 0)
+    return;
+  
+  // (going back to the screen, there is nothing to restore)
+  _viewportDepth--;
+#if LCD_VIEWPORT_DEPTH > 1
+  if (_viewportDepth)
+    _view = _viewports [_viewportDepth - 1];
+#endif
+  
+  if (_viewportDepth == 0 && !_placed && 
+      _textX >= 0 && _textX < width () && _textY >= 0 && _textY < height ())
+    gotoxy (_textX, _textY);
+}  // end of I2C_graphical_LCD_display::popViewport
+
+// shrink the clip rectangle (screen coordinates, inclusive) - it can end up empty
+void I2C_graphical_LCD_display::clipTo (const int x1, 
+                                        const int y1, 
+                                        const int x2, 
+                                        const int y2)
+{
+  if (x1 > _view.clipX1)
+    _view.clipX1 = x1;
+  if (y1 > _view.clipY1)
+    _view.clipY1 = y1;
+  if (x2 < _view.clipX2)
+    _view.clipX2 = x2;
+  if (y2 < _view.clipY2)
+    _view.clipY2 = y2;
+}  // end of I2C_graphical_LCD_display::clipTo
+
+// which rows of the byte at column x (screen coordinates) of the page starting at row "top" 
+// are inside the clip rectangle (0 = none)
+byte I2C_graphical_LCD_display::clipMask (const int x, 
+                                          const int top) const
+{
+  if (x < _view.clipX1 || x > _view.clipX2 || !clipPage (top))
+    return 0;
+  
+  byte mask = 0xFF;
+  if (top < _view.clipY1)
+    mask <<= _view.clipY1 - top;
+  if (top + 7 > _view.clipY2)
+    mask >>= top + 7 - _view.clipY2;
+  return mask;
+}  // end of I2C_graphical_LCD_display::clipMask
+
+// move a rectangle (inclusive) from viewport to screen coordinates, and cut it down to the clip
+// rectangle (if nothing is left, x1 > x2 or y1 > y2)
+void I2C_graphical_LCD_display::clipRect (int & x1, 
+                                          int & y1, 
+                                          int & x2, 
+                                          int & y2) const
+{
+  x1 += _view.x;
+  y1 += _view.y;
+  x2 += _view.x;
+  y2 += _view.y;
+  if (x1 < _view.clipX1)
+    x1 = _view.clipX1;
+  if (y1 < _view.clipY1)
+    y1 = _view.clipY1;
+  if (x2 > _view.clipX2)
+    x2 = _view.clipX2;
+  if (y2 > _view.clipY2)
+    y2 = _view.clipY2;
+}  // end of I2C_graphical_LCD_display::clipRect
+
+// start recording a display list into buf (size bytes)
+// until endRecord, gotoxy, writeData, letter (and so string and print), blit, clear, setPixel, 
+// fillRect, fillPattern, frameRect and line are stored rather than drawn - other calls work as usual
+// the list is replayed from where the cursor is now
+void I2C_graphical_LCD_display::beginRecord (byte * buf, 
+                                             const unsigned int size)
+{
+  _record = buf;
+  _recordSize = size;
+  _recordLength = 0;
+  _recordRun = 0;
+  _recordOverflow = false;
+  _recording = false;   // so the starting position is known: we don't record gotoxy calls yet
+  
+  byte op [] = { LCD_OP_GOTO, cursorX (), cursorY () };
+  record (op, sizeof op);
+  
+  _recording = true;
+}  // end of I2C_graphical_LCD_display::beginRecord
+
+// stop recording - the list can now be drawn with render (as often as you like)
+void I2C_graphical_LCD_display::endRecord ()
+{
+  _recording = false;
+}  // end of I2C_graphical_LCD_display::endRecord
+
+// add an operation to the display list
+void I2C_graphical_LCD_display::record (const byte * op, 
+                                        const byte length)
+{
+  _recordRun = 0;
+  
+  // once something is lost, don't record anything after it either
+  if (_recordOverflow || _recordLength + length > _recordSize)
+    {
+    _recordOverflow = true;
+    return;
+    }
+  
+  memcpy (&_record [_recordLength], op, length);
+  _recordLength += length;
+}  // end of I2C_graphical_LCD_display::record
+
+// add a letter (or data byte) to the display list - consecutive ones share a single op
+void I2C_graphical_LCD_display::recordRun (const byte op, 
+                                           const byte inv, 
+                                           const byte data)
+{
+  // same sort of run as last time, with room in it?
+  if (_recordRun && 
+      !_recordOverflow &&
+      _record [_recordRun] == op && 
+      _record [_recordRun + 1] == inv && 
+      _record [_recordRun + 2] < 255 &&
+      _recordLength < _recordSize)
+    {
+    _record [_recordRun + 2]++;
+    _record [_recordLength++] = data;
+    return;
+    }
+  
+  byte header [] = { op, inv, 1, data };
+  record (header, sizeof header);
+  if (!_recordOverflow)
+    _recordRun = _recordLength - sizeof header;
+}  // end of I2C_graphical_LCD_display::recordRun
+
+// carry out everything in the display list (wherever writeData is sending things at present)
+void I2C_graphical_LCD_display::replay ()
+{
+  unsigned int i = 0;
+  const byte * p;
+  
+  while (i < _recordLength)
+    {
+    p = &_record [i];
+    switch (p [0])
+      {
+      case LCD_OP_GOTO:  
+        gotoxy (p [1], p [2]); 
+        i += 3; 
+        break;
+        
+      case LCD_OP_DATA:
+        for (byte j = 0; j < p [2]; j++)
+          writeData (p [3 + j], false);
+        i += 3 + p [2];
+        break;
+        
+      case LCD_OP_TEXT:
+        for (byte j = 0; j < p [2]; j++)
+          letter (p [3 + j], p [1]);
+        i += 3 + p [2];
+        break;
+        
+      case LCD_OP_BLIT:
+        {
+        const byte * pic;
+        memcpy (&pic, &p [1], sizeof pic);
+        blit (pic, p [1 + sizeof pic] | (p [2 + sizeof pic] << 8));
+        i += 1 + sizeof pic + 2;
+        }
+        break;
+        
+      case LCD_OP_CLEAR: 
+        clear (p [1], p [2], p [3], p [4], p [5]); 
+        i += 6; 
+        break;
+        
+      case LCD_OP_PIXEL: 
+        setPixel (p [1], p [2], p [3]); 
+        i += 4; 
+        break;
+        
+      case LCD_OP_FILL:  
+        fillRect (p [1], p [2], p [3], p [4], p [5]); 
+        i += 6; 
+        break;
+        
+      case LCD_OP_FRAME: 
+        frameRect (p [1], p [2], p [3], p [4], p [5], p [6]); 
+        i += 7; 
+        break;
+        
+      case LCD_OP_LINE:  
+        line (p [1], p [2], p [3], p [4], p [5]); 
+        i += 6; 
+        break;
+        
+      case LCD_OP_BITMAP:
+        {
+        const byte * pic;
+        memcpy (&pic, &p [1], sizeof pic);
+        bitmap (p [1 + sizeof pic], p [2 + sizeof pic], pic, p [3 + sizeof pic], p [4 + sizeof pic]);
+        i += 1 + sizeof pic + 4;
+        }
+        break;
+        
+      case LCD_OP_PATTERN:
+        {
+        const byte * pattern;
+        memcpy (&pattern, &p [1], sizeof pattern);
+        fillPattern (p [1 + sizeof pattern], p [2 + sizeof pattern], p [3 + sizeof pattern], p [4 + sizeof pattern], pattern);
+        i += 1 + sizeof pattern + 4;
+        }
+        break;
+        
+      default:
+        return;   // shouldn't happen
+      }  // end of switch
+    }  // end of while
+}  // end of I2C_graphical_LCD_display::replay
+
+// draw the display list
+// For each page of each chip, the whole list is replayed into a 64-byte window in RAM (so pixel
+// operations read from there, not the LCD), then the columns which were drawn on are sent in one go.
+// That is 16 replays - cheap compared to the bus - and only one gotoxy per page per chip.
+// The cursor is left where the recorded calls left it.
+boolean I2C_graphical_LCD_display::render ()
+{
+  if (_recording)
+    endRecord ();
+  if (_record == NULL)
+    return false;
+  
+  byte window [64];
+  byte x = 0, y = 0;   // where the recorded calls leave the cursor
+  byte sink = _sink;   // the LCD, or a frame buffer
+  byte rotation = _rotation;
+  
+  // portrait is only for frame buffers - on the LCD the calls are drawn 128 x 64, as they would be directly
+  if (sink == LCD_SINK_BUS && (rotation & LCD_ROTATE_90))
+    _rotation = LCD_ROTATE_0;
+  
+  _window = window;
+  beginBatch ();
+  
+  for (byte page = 0; page < 8; page++)
+    for (byte chip = 0; chip < 2; chip++)
+      {
+      memset (window, 0, sizeof window);
+      _windowChip = chip ? LCD_CS2 : LCD_CS1;
+      _windowPage = page;
+      _windowFirst = 64;
+      _windowLast = 0;
+      
+      _sink = LCD_SINK_WINDOW;
+      replay ();
+      _sink = sink;
+      
+      x = cursorX ();
+      y = cursorY ();
+      
+      if (_windowFirst > _windowLast)
+        continue;   // nothing drawn here
+      
+      // the window is in screen coordinates (any viewport was applied while drawing into it)
+      byte depth = _viewportDepth;
+      _viewportDepth = 0;
+      if (portrait ())
+        gotoxy (_windowFirst, (page * 2 + chip) * 8);   // (where that page of a portrait frame is)
+      else
+        gotoxy (chip * 64 + _windowFirst, page * 8);
+      for (byte i = _windowFirst; i <= _windowLast; i++)
+        writeData (window [i], false);
+      _viewportDepth = depth;
+      }  // end of for each page and chip
+  
+  // (in a viewport, the cursor is already where the recorded calls left it)
+  if (_viewportDepth)
+    _placed = false;
+  else
+    gotoxy (x, y);
+  endBatch ();
+  _rotation = rotation;
+  
+  return !_recordOverflow;
+}  // end of I2C_graphical_LCD_display::render
+
+// draw into a frame buffer (LCD_FRAME_SIZE bytes) rather than the LCD - NULL to draw on the LCD again
+// everything works the same way (including reading back for setPixel) but nothing is sent
+void I2C_graphical_LCD_display::setTarget (byte * frame)
+{
+  _frame = frame;
+  _sink = frame ? LCD_SINK_FRAME : LCD_SINK_BUS;
+}  // end of I2C_graphical_LCD_display::setTarget
+
+// send a frame buffer to the LCD
+// if "shown" is supplied it must hold what is on the LCD now: only the bytes which differ are 
+// sent (with runs less than LCD_DIFF_GAP apart joined up) and "shown" is updated to match
+// the cursor is left at the end of the last byte sent (unless drawing into a frame buffer)
+void I2C_graphical_LCD_display::display (const byte * frame, 
+                                         byte * shown,
+                                         const byte x1, 
+                                         const byte page1, 
+                                         const byte x2, 
+                                         const byte page2)
+{
+  // this always goes to the LCD, even if we are drawing into a frame buffer at present
+  byte sink = _sink;
+  byte oldx = _lcdx, oldy = _lcdy, oldChip = _chipSelect;
+  byte depth = _viewportDepth;
+  _sink = LCD_SINK_BUS;
+  _viewportDepth = 0;   // the frame is the whole screen
+  
+  beginBatch ();
+  if (_rotation & LCD_ROTATE_90)
+    displayPortrait (frame, shown, x1, page1, x2, page2);
+  else
+    for (byte page = page1; page <= page2 && page < 8; page++)
+      {
+      const byte * now = &frame [page * 128];
+      byte * was = shown ? &shown [page * 128] : NULL;
+      int x = x1;
+      
+      while (x <= x2 && x < 128)
+        {
+        // skip what is there already
+        if (was && now [x] == was [x])
+          {
+          x++;
+          continue;
+          }
+        
+        // find the end of this run: stop when there are too many unchanged bytes in a row
+        int last = x;
+        for (int i = x + 1; i <= x2 && i < 128 && i - last <= LCD_DIFF_GAP + 1; i++)
+          if (!was || now [i] != was [i])
+            last = i;
+        
+        gotoxy (x, page * 8);
+        for ( ; x <= last; x++)
+          {
+          writeData (now [x], false);
+          if (was)
+            was [x] = now [x];
+          }
+        }  // end of while
+      }  // end of for each page
+  endBatch ();
+  
+  // back to drawing into the frame buffer?
+  _sink = sink;
+  if (_sink != LCD_SINK_BUS)
+    {
+    _lcdx = oldx;
+    _lcdy = oldy;
+    _chipSelect = oldChip;
+    }
+  _viewportDepth = depth;
+  _placed = false;
+}  // end of I2C_graphical_LCD_display::display
+
+// send a portrait frame (16 pages of 64 bytes): each 8 x 8 block of it is turned round (transpose8) 
+// into 8 columns of the LCD. Blocks in a row across the LCD are sent together.
+// LCD_ROTATE_90:  page p, columns 8b to 8b + 7 go to LCD page b, columns 8 (15 - p) onwards
+// LCD_ROTATE_270: they go to LCD page 7 - b, columns 8p onwards, the other way round
+// x1 to x2 and page1 to page2 are in the frame's coordinates (whole blocks are sent)
+void I2C_graphical_LCD_display::displayPortrait (const byte * frame, 
+                                                 byte * shown,
+                                                 const byte x1, 
+                                                 const byte page1, 
+                                                 byte x2, 
+                                                 byte page2)
+{
+  boolean turn270 = _rotation == LCD_ROTATE_270;
+  byte block [8];
+  byte columns [8];
+  
+  if (x2 > 63)
+    x2 = 63;
+  if (page2 > 15)
+    page2 = 15;
+  if (x1 > x2 || page1 > page2)
+    return;
+  
+  for (byte b = x1 >> 3; b <= (x2 >> 3); b++)
+    {
+    boolean placed = false;   // the LCD's cursor is just after the last block sent
+    
+    // left to right across the LCD
+    for (byte i = 0; i <= page2 - page1; i++)
+      {
+      byte page = turn270 ? page1 + i : page2 - i;
+      const byte * now = &frame [page * 64 + b * 8];
+      
+      // skip what is there already
+      if (shown)
+        {
+        byte * was = &shown [page * 64 + b * 8];
+        if (memcmp (now, was, 8) == 0)
+          {
+          placed = false;
+          continue;
+          }
+        memcpy (was, now, 8);
+        }
+      
+      if (!placed)
+        {
+        if (turn270)
+          gotoxy (page * 8, (7 - b) * 8);
+        else
+          gotoxy ((15 - page) * 8, b * 8);
+        placed = true;
+        }
+      
+      if (turn270)
+        {
+        for (byte r = 0; r < 8; r++)
+          block [r] = now [7 - r];
+        transpose8 (block, columns);
+        for (byte c = 0; c < 8; c++)
+          writeData (columns [7 - c], false);
+        }
+      else
+        {
+        transpose8 (now, columns);
+        for (byte c = 0; c < 8; c++)
+          writeData (columns [c], false);
+        }
+      }  // end of for each block
+    }  // end of for each row of blocks
+}  // end of I2C_graphical_LCD_display::displayPortrait
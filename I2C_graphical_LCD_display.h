@@ -20,6 +20,26 @@
  -- also increased initial LCD_BUSY_DELAY from 20 to 50 uS
  Version 1.10:  8 July 2012      -- fixed issue with dropping enable before reading from display
  Version 1.11: 15 August 2014    -- added support for Print class, and an inverse mode
+ Version 1.12: 19 October 2026   -- added batched transfers (beginBatch / endBatch), strip chart widget
+                                 -- faster begin, with options to skip clearing or detect a warm restart
+                                 -- added readRegion and PBM screenshots
+                                 -- can be compiled on a Linux host, talking to an emulator (see host/)
+                                 -- print sends a whole string (or number) in one batch, added printFixed
+                                 -- added display lists (beginRecord / endRecord / render)
+                                 -- wide clears, scroll and turning on go to both chips at once
+                                 -- can draw into a frame buffer (setTarget), and send only what changed (display)
+                                 -- added writeRun, and LCD_dither for grayscale images
+                                 -- added bitmap (any y position), and LCD_bitmap.h to make them at compile time
+                                 -- added importRows and blitRows for row-by-row (1 bit per pixel) images
+                                 -- added autotune (fastest reliable I2C clock, or SPI delay), setSpeed, saveSpeed
+                                 -- bus errors are counted, and verify repairs pages they (or anything else) damaged
+                                 -- added viewports (pushViewport / pushClip / popViewport): drawing is moved and clipped
+                                 -- added measureText, and textBox: word-wrapped, aligned text, each line sent once
+                                 -- added setRotation: upside down (no extra bus traffic), or portrait frame buffers
+                                 -- added fillPattern: 8 x 8 pattern fills (greys, hatches) at the speed of clear
+                                 -- added LCD_grayscale: four grey levels by temporal dithering, at a steady frame rate
+                                 -- added LCD_damage: changed regions of a frame sent most urgent first, with deadlines
+                                 -- added LCD_animation: keyframe plus deltas in PROGMEM, and host/lcd_animation_tool
  
  * These changes required hardware changes to pin configurations
  
@@ -55,12 +75,15 @@
 
 #if defined(ARDUINO) && ARDUINO >= 100
   #include "Arduino.h"
-#else
+  #include <avr/pgmspace.h>
+#elif defined(ARDUINO)
   #include <WProgram.h>
+  #include <avr/pgmspace.h>
+#else
+  // not an Arduino: a Linux host, using an LCD_transport (eg. host/LCD_emulator.h) instead of Wire or SPI
+  #include "host/LCD_host.h"
 #endif
 
-#include <avr/pgmspace.h>
-
 // MCP23017 registers (everything except direction defaults to 0)
 
 #define IODIRA   0x00   // IO direction  (0 = output, 1 = input (Default))
@@ -168,6 +191,110 @@
 #define LCD_SET_PAGE    0xB8   // plus Y address (0 to 7)
 #define LCD_DISP_START  0xC0   // plus X address (0 to 63) - for scrolling
 
+// Status read from LCD (LCD_READ bit set to 1, LCD_DATA bit set to 0)
+
+#define LCD_STATUS_BUSY   0x80   // busy with internal operation
+#define LCD_STATUS_OFF    0x20   // display is off
+#define LCD_STATUS_RESET  0x10   // in reset
+
+// Options for begin
+
+#define LCD_BEGIN_NO_CLEAR  0x01   // don't clear the display memory
+#define LCD_BEGIN_WARM      0x02   // if the display is already running (eg. after a watchdog reset) leave it alone
+
+// Where writeData sends data (used internally)
+
+#define LCD_SINK_BUS     0   // to the LCD
+#define LCD_SINK_WINDOW  1   // to one page of one chip in RAM, while rendering a display list
+#define LCD_SINK_FRAME   2   // to a frame buffer (see setTarget)
+
+// Frame buffers: 8 pages of 128 bytes (LSB at the top of each byte), page 0 first
+
+#define LCD_FRAME_SIZE   (128 * 64 / 8)
+
+// When sending a frame, runs of changed bytes this close together are sent as one 
+// (re-sending an unchanged byte is cheaper than the gotoxy to skip it)
+
+#define LCD_DIFF_GAP     2
+
+// SPI is so fast we need to give the LCD time to catch up.
+// This is the number of microseconds we wait (to start with - see autotune and setSpeed).
+// Something like 20 to 50 is probably reasonable.
+//  Increase this value if the display is either not working, or losing data.
+
+#define LCD_BUSY_DELAY   50   // microseconds
+
+// verify keeps a checksum of each page of what should be on the LCD (32 bytes of RAM), so a page
+// nothing has been drawn on since it was last checked isn't gone through again. Set this to 0 to
+// save the RAM: verify then compares what it reads back with what was drawn, byte by byte.
+
+#ifndef LCD_VERIFY_CHECKSUMS
+  #define LCD_VERIFY_CHECKSUMS  1
+#endif
+
+// How many viewports can be pushed (see pushViewport) - each after the first takes 12 bytes of RAM
+// (on a Uno). 1 = one at a time (no stack), 0 = none (pushViewport and pushClip always fail).
+
+#ifndef LCD_VIEWPORT_DEPTH
+  #define LCD_VIEWPORT_DEPTH  4
+#endif
+
+// Text alignment (see textBox)
+
+#define LCD_ALIGN_LEFT     0
+#define LCD_ALIGN_CENTRE   1
+#define LCD_ALIGN_RIGHT    2
+#define LCD_ALIGN_JUSTIFY  3   // spaces widened so wrapped lines fill the box (the last line of a paragraph is left-aligned)
+
+// Upside down, data is held back so a run of it can be sent right to left (see setRotation): this
+// many bytes at most. A longer run is sent in pieces, each costing another page and address command.
+
+#ifndef LCD_RUN_SIZE
+  #define LCD_RUN_SIZE  32
+#endif
+
+// Rotation (see setRotation)
+
+#define LCD_ROTATE_0     0
+#define LCD_ROTATE_90    1   // portrait, the top of the picture at the right-hand side of the LCD
+#define LCD_ROTATE_180   2   // upside down
+#define LCD_ROTATE_270   3   // portrait, the top of the picture at the left-hand side of the LCD
+
+// Fill patterns (see fillPattern): 8 column bytes each, top row in the low bit, like a bitmap.
+// The greys are ordered dither, so neighbouring levels blend smoothly.
+
+extern const byte LCD_patterns [] [8] PROGMEM;
+
+#define LCD_PATTERN_WHITE          (LCD_patterns [0])
+#define LCD_PATTERN_GREY12         (LCD_patterns [1])   // 1 pixel in 8 black
+#define LCD_PATTERN_GREY25         (LCD_patterns [2])
+#define LCD_PATTERN_GREY50         (LCD_patterns [3])   // fine checkerboard
+#define LCD_PATTERN_GREY75         (LCD_patterns [4])
+#define LCD_PATTERN_GREY87         (LCD_patterns [5])
+#define LCD_PATTERN_BLACK          (LCD_patterns [6])
+#define LCD_PATTERN_HORIZONTAL     (LCD_patterns [7])   // lines 4 pixels apart
+#define LCD_PATTERN_VERTICAL       (LCD_patterns [8])
+#define LCD_PATTERN_DIAGONAL       (LCD_patterns [9])   // like /
+#define LCD_PATTERN_BACK_DIAGONAL  (LCD_patterns [10])  // the other way
+#define LCD_PATTERN_GRID           (LCD_patterns [11])  // horizontal and vertical
+#define LCD_PATTERN_CROSSHATCH     (LCD_patterns [12])  // both diagonals
+#define LCD_PATTERN_CHECKER        (LCD_patterns [13])  // 4 x 4 squares
+
+// autotune writes this many test patterns, and reads them back, at each speed it tries
+
+#define LCD_TUNE_PASSES  4
+
+// The fastest I2C clock setSpeed (and so autotune) will use. On AVR that is F_CPU / 16 (TWBR = 0):
+// asking for more makes the TWBR sum go negative, and the bus ends up very slow instead.
+
+#ifndef LCD_MAX_CLOCK
+  #if defined (__AVR__) && defined (F_CPU)
+    #define LCD_MAX_CLOCK  (F_CPU / 16)
+  #else
+    #define LCD_MAX_CLOCK  1700000UL   // the MCP23017's limit
+  #endif
+#endif
+
 class I2C_graphical_LCD_display : public Print
 {
 private:
@@ -178,15 +305,125 @@ private:
   
   byte _port;        // port that the MCP23017 is on (should be 0x20 to 0x27)
   byte _ssPin;       // if non-zero use SPI rather than I2C (and this is the SS pin)
+  
+  unsigned long _busClock;   // I2C clock in Hz (0 = whatever Wire uses)
+  unsigned int _busyDelay;   // microseconds between SPI transfers, for the LCD to catch up
 
   void expanderWrite (const byte reg, const byte data);
+  byte expanderRead (const byte reg);
   byte readData ();
+  byte readDataPort ();
+  void readRun (byte * buf, const byte count);
+  byte readStatus ();   // status of the currently-selected chip
   void startSend ();    // prepare for sending to MCP23017  (eg. set SS low)
   void doSend (const byte what);  // send a byte to the MCP23017
   void endSend ();      // finished sending  (eg. set SS high)
 
   boolean _invmode;
   
+  byte _batchDepth;           // how many beginBatch calls are outstanding
+  unsigned int _batchBytes;   // bytes in the currently-open batch transaction (0 = none open)
+  
+  void strobe (const byte control, const byte data);  // queue one E pulse into the batch
+  void fillBoth (const byte page, const byte from, const byte to, const byte val, const byte * pattern = NULL);
+  void fillRow (const byte page, byte x1, byte x2, const byte val, const byte * pattern = NULL);
+  void closeBatch ();         // finish the open batch transaction, if any
+  
+  static void pbmHeader (Print & out, const byte w, const byte h, const boolean ascii);
+  static void pbmPage (Print & out, const byte * buf, const byte w, const boolean ascii);
+  static void transpose8 (const byte * rows, byte * columns);
+  
+  boolean tuneTest (const byte page);
+  void tuneRead (const byte page, byte * buf);
+  void readBack (byte * buf, const byte count);   // from the LCD itself, never the cache
+  
+  size_t printNumber (unsigned long n, const boolean negative, byte decimals);
+  static const char * wrapLine (const char * s, const byte chars, byte & count, boolean & wrapped);
+  
+  // display list (see beginRecord)
+  byte * _record;              // where drawing calls are recorded (NULL = none)
+  unsigned int _recordSize;    // size of that buffer
+  unsigned int _recordLength;  // bytes used so far
+  unsigned int _recordRun;     // start of the last text or data run, so it can be extended (0 = none)
+  boolean _recording;          // true between beginRecord and endRecord
+  boolean _recordOverflow;     // something didn't fit
+  
+  // where writeData sends its bytes: the LCD, or (while rendering) one page of one chip in RAM
+  byte _sink;
+  byte * _window;              // 64 bytes: one page of one chip
+  byte _windowChip;            // LCD_CS1 or LCD_CS2
+  byte _windowPage;            // 0 to 7
+  byte _windowFirst;           // first column written to the window (64 = none)
+  byte _windowLast;            // last column written to the window
+  
+  byte * _frame;               // frame buffer being drawn into (see setTarget)
+  
+  // bus faults (see verify) - "pages" here are one page of one chip (64 bytes): bit n is 
+  // page (n & 7) of chip (n >> 3)
+  byte * _reference;             // what the LCD should be showing (see setReference)
+#if LCD_VERIFY_CHECKSUMS
+  unsigned int _checksum [16];   // checksum of each page of that
+#endif
+  unsigned int _checkValid;      // which checksums are up to date
+  unsigned int _sending;         // pages written to since the bus last said all was well
+  unsigned int _suspect;         // pages being written to when the bus reported an error
+  byte _verifyNext;              // next page verify looks at (after any suspect ones)
+  unsigned long _busErrors;
+  unsigned long _pagesChecked;
+  unsigned long _pagesRepaired;
+  
+  void record (const byte * op, const byte length);
+  void recordRun (const byte op, const byte inv, const byte data);
+  void replay ();
+  boolean inWindow () const { return _chipSelect == _windowChip && (_lcdy >> 3) == _windowPage; }
+  int frameOffset () const { return (_lcdy >> 3) * 128 + _lcdx + (_chipSelect == LCD_CS2 ? 64 : 0); }
+  unsigned int cursorPages () const   // the page under the cursor (on both chips, if both are selected)
+    { return (((_chipSelect & LCD_CS1) ? 0x001 : 0) | ((_chipSelect & LCD_CS2) ? 0x100 : 0)) << (_lcdy >> 3); }
+  void busFault () { _busErrors++; _suspect |= _sending; }
+  
+  // viewports (see pushViewport): origin and clip rectangle (inclusive), in screen coordinates
+  struct Viewport
+    {
+    int x, y;
+    int clipX1, clipY1, clipX2, clipY2;
+    };
+  Viewport _view;                              // the one in use (if _viewportDepth > 0)
+#if LCD_VIEWPORT_DEPTH > 1
+  Viewport _viewports [LCD_VIEWPORT_DEPTH - 1];   // the ones pushed before it (not the screen)
+#endif
+  byte _viewportDepth;                         // 0 = none: screen coordinates, nothing clipped
+  int _textX, _textY;                          // cursor (screen coordinates) while in a viewport
+  boolean _placed;                             // the LCD's own cursor is at _textX, _textY
+  
+  void clipTo (const int x1, const int y1, const int x2, const int y2);
+  byte clipMask (const int x, const int top) const;   // rows of the page at "top" inside the clip
+  void clipRect (int & x1, int & y1, int & x2, int & y2) const;   // to screen, and inside the clip
+  void clipClear (const byte x1, const byte y1, const byte x2, const byte y2, const byte val);
+  boolean clipPage (const int top) const { return top <= _view.clipY2 && top + 7 >= _view.clipY1; }
+  void intended (const byte page, byte * buf) const;
+  
+  // rotation (see setRotation)
+  byte _rotation;
+  byte _run [LCD_RUN_SIZE];   // upside down: a run of data waiting to be sent backwards (see sendRun)
+  byte _runLength;
+  byte _runX;        // where it starts (before turning round)
+  byte _runPage;
+  byte _runChip;
+  
+  void sendRun ();
+  void displayPortrait (const byte * frame, byte * shown, const byte x1, const byte page1, byte x2, byte page2);
+  boolean portrait () const { return (_rotation & LCD_ROTATE_90) && _sink != LCD_SINK_BUS; }
+  // the cursor, in the coordinates drawing uses (in portrait, page n of a frame buffer is kept where
+  // page n / 2 of chip 1 (n even) or chip 2 (n odd) would be, so each is 64 bytes after the one before)
+  byte cursorX () const { return _lcdx + (_chipSelect == LCD_CS2 && !portrait () ? 64 : 0); }
+  byte cursorY () const { return portrait () ? ((_lcdy & ~7) << 1) + (_chipSelect == LCD_CS2 ? 8 : 0) + (_lcdy & 7) : _lcdy; }
+  void toEdge (byte & x, byte & y) const   // past the edge (eg. 255) means up to it
+    { if (x >= width ()) x = width () - 1; if (y >= height ()) y = height () - 1; }
+  
+#ifndef ARDUINO
+  LCD_transport * _transport;   // what carries our bytes to the MCP23017 on a host
+#endif
+  
   
 #ifdef WRITETHROUGH_CACHE
   byte _cache [64 * 128 / 8];
@@ -196,9 +433,23 @@ private:
 public:
   
   // constructor
-  I2C_graphical_LCD_display () : _port (0x20), _ssPin (10), _invmode(false) {};
+  I2C_graphical_LCD_display () : _port (0x20), _ssPin (10), _busClock (0), _busyDelay (LCD_BUSY_DELAY), _invmode(false),
+                                  _batchDepth (0), _batchBytes (0), 
+                                  _record (NULL), _recordLength (0), _recording (false), _sink (LCD_SINK_BUS),
+                                  _frame (NULL), _reference (NULL), _checkValid (0), _sending (0), _suspect (0),
+                                  _verifyNext (0), _busErrors (0), _pagesChecked (0), _pagesRepaired (0),
+                                  _viewportDepth (0), _rotation (LCD_ROTATE_0), _runLength (0)
+#ifndef ARDUINO
+                                  , _transport (NULL)
+#endif
+                                  {};
   
-  void begin (const byte port = 0x20, const byte i2cAddress = 0, const byte ssPin = 0);
+#ifndef ARDUINO
+  // on a host, call this before begin
+  void setTransport (LCD_transport & transport) { _transport = &transport; }
+#endif
+  
+  boolean begin (const byte port = 0x20, const byte i2cAddress = 0, const byte ssPin = 0, const byte options = 0);
   void cmd (const byte data);
   void gotoxy (byte x, byte y);
   void writeData (byte data, const boolean inv);
@@ -208,21 +459,46 @@ public:
   void string (const char * s, const boolean inv);
   void string (const char * s) {string(s, _invmode);}
   void blit (const byte * pic, const unsigned int size);
+  void writeRun (const byte * data, const unsigned int size);   // like blit, but from RAM, in one batch
+  void bitmap (const byte x, const byte y, const byte * pic, byte w, const byte h);  // see LCD_bitmap.h
+  
+  // text layout: letters are 6 pixels wide (including the gap after them) and 8 high.
+  // measureText gives the width of the widest line of s (lines end at '\n'), in pixels.
+  // textLines gives how many lines s takes when word-wrapped to w pixels.
+  // textBox word-wraps s to w pixels (a word is only split if it is too long for a line by itself,
+  // '\n' starts a new line) and aligns each line (LCD_ALIGN_LEFT etc.) inside the box at x,y
+  // (y is forced to a multiple of 8). Each line is sent once, padded with blanks to the width of 
+  // the box, in one batch. Lines of the box below the text are cleared.
+  // Returns how many characters of s were drawn - strlen (s) if it all fitted in h pixels.
+  static unsigned int measureText (const char * s);
+  static byte textLines (const char * s, const byte w);
+  unsigned int textBox (const byte x, const byte y, byte w, const byte h, const char * s, const byte align = LCD_ALIGN_LEFT);
+  
+  // images stored a row at a time (1 = black, leftmost pixel in the high bit, "stride" bytes per row)
+  // importRows converts 8 rows (or "count" if fewer) to w column bytes, eg. straight into a frame buffer
+  // blitRows draws a whole image at x,y (y is forced to the nearest (lower) 8 pixels, like clear)
+  static void importRows (const byte * rows, const unsigned int stride, const byte w, byte * page, const byte count = 8);
+  void blitRows (const byte x, const byte y, const byte * rows, const unsigned int stride, byte w, const byte h);
   void clear (const byte x1 = 0,    // start pixel
               const byte y1 = 0,     
-              const byte x2 = 127,  // end pixel
-              const byte y2 = 63,   
+              byte x2 = 255,        // end pixel (past the edge means up to the edge)
+              byte y2 = 255,   
               const byte val = 0);   // what to fill with 
   void setPixel (const byte x, const byte y, const byte val = 1);
+  // fill x1,y1 to x2,y2 (inclusive, to the pixel) with an 8 x 8 pattern (eg. LCD_PATTERN_GREY25, or 
+  // your own 8 bytes in PROGMEM). The pattern lines up with the screen, so areas filled separately 
+  // join without a seam. Whole pages cost the same as clear; only a partial top or bottom page 
+  // is read first.
+  void fillPattern (const byte x1, const byte y1, byte x2, byte y2, const byte * pattern);
   void fillRect (const byte x1 = 0,   // start pixel
                 const byte y1 = 0,     
-                const byte x2 = 127, // end pixel
-                const byte y2 = 63,    
+                byte x2 = 255,       // end pixel (past the edge means up to the edge)
+                byte y2 = 255,    
                 const byte val = 1);  // what to draw (0 = white, 1 = black) 
   void frameRect (const byte x1 = 0,    // start pixel
                  const byte y1 = 0,     
-                 const byte x2 = 127, // end pixel
-                 const byte y2 = 63,    
+                 byte x2 = 255,       // end pixel (past the edge means up to the edge)
+                 byte y2 = 255,    
                  const byte val = 1,    // what to draw (0 = white, 1 = black) 
                  const byte width = 1);
   void line  (const byte x1 = 0,    // start pixel
@@ -231,15 +507,117 @@ public:
               const byte y2 = 63,   
               const byte val = 1);  // what to draw (0 = white, 1 = black) 
   void scroll (const byte y = 0);   // set scroll position
+  
+  // rotation: LCD_ROTATE_180 turns everything upside down, as it is sent to (or read from) the LCD - 
+  // each run of bytes is sent backwards, so it costs nothing extra when batched (outside a batch
+  // every byte needs its own address). 
+  // LCD_ROTATE_90 and LCD_ROTATE_270 are for frame buffers (see setTarget): drawing into one is then
+  // 64 pixels wide and 128 high, and display turns it round, 8 x 8 pixels at a time, as it sends it
+  // (drawing straight on the LCD, or into a display list rendered on it, stays 128 x 64).
+  // width and height give the size of what is being drawn on.
+  void setRotation (const byte rotation);
+  byte rotation () const { return _rotation; }
+  byte width () const { return portrait () ? 64 : 128; }
+  byte height () const { return portrait () ? 128 : 64; }
 
-#if defined(ARDUINO) && ARDUINO >= 100
+  // commands and data sent between these are packed into as few bus transactions as possible
+  void beginBatch ();
+  void endBatch ();
+
+  // viewports: after pushViewport, coordinates are relative to x,y (relative to the viewport before,
+  // if any), and nothing outside w x h pixels from there - or outside the viewport before - is drawn.
+  // pushClip just clips (to x1,y1,x2,y2, inclusive), leaving the origin where it was.
+  // Anything which can't be seen costs no bus traffic, and text or data going past the right-hand
+  // side is cut off rather than wrapping. Pages only partly inside are read first, so what is 
+  // outside is left alone. Text, data and clear work in whole pages (bytes), so keep the y origin
+  // a multiple of 8 for those. Returns false if LCD_VIEWPORT_DEPTH are in use already.
+  // Viewports aren't recorded in display lists: the one in use when render is called applies.
+  // verify, display, screenshot and render's sending to the LCD always use screen coordinates.
+  boolean pushViewport (const int x, const int y, const byte w, const byte h);
+  boolean pushClip (const int x1, const int y1, const int x2, const int y2);
+  void popViewport ();   // back to the one before (at the end of the last, the cursor is put on the LCD)
+  
+  // read back display memory, and write it as a PBM image (eg. to Serial)
+  void readRegion (const byte x, const byte y, const byte w, const byte pages, byte * buf);
+  void screenshot (Print & out, const boolean ascii = false);
+  static void writePBM (Print & out, const byte * buf, const byte w, const byte pages, const boolean ascii = false);
+
+  // display list: drawing calls between beginRecord and endRecord are stored in buf rather than drawn
+  // render then draws them all, onto a blank background, one page of one chip at a time, sending each 
+  // page of each chip once (only the columns the calls touched are sent)
+  void beginRecord (byte * buf, const unsigned int size);
+  void endRecord ();
+  boolean render ();   // returns false if buf was too small for everything (what fitted is drawn)
+
+  // frame buffers (LCD_FRAME_SIZE bytes): after setTarget, drawing goes into the frame rather
+  // than the LCD (setTarget (NULL) to go back). display sends a frame to the LCD - if "shown" is 
+  // given (what the LCD shows now) only the bytes which differ are sent, and "shown" is updated.
+  // Optionally only columns x1 to x2 of pages page1 to page2 are looked at.
+  // Portrait frames (see setRotation) are 16 pages of 64 bytes, and are sent 8 x 8 pixels at a time.
+  void setTarget (byte * frame);
+  void display (const byte * frame, 
+                byte * shown = NULL, 
+                const byte x1 = 0, 
+                const byte page1 = 0, 
+                const byte x2 = 255, 
+                const byte page2 = 255);
+
+#if !defined(ARDUINO) || ARDUINO >= 100
 	size_t write(uint8_t c) {letter(c, _invmode); return 1; }
+  size_t write (const uint8_t * buffer, size_t size);   // whole string in one batch
+  
+  // numbers in decimal go straight to the font (no conversion to a string first)
+  using Print::print;
+  using Print::println;
+  size_t print (int n, int base = DEC)            { return print ((long) n, base); }
+  size_t print (unsigned int n, int base = DEC)   { return print ((unsigned long) n, base); }
+  size_t print (long n, int base = DEC);
+  size_t print (unsigned long n, int base = DEC);
+  size_t print (double n, int digits = 2);
+  size_t println (int n, int base = DEC)          { return print (n, base) + println (); }
+  size_t println (unsigned int n, int base = DEC) { return print (n, base) + println (); }
+  size_t println (long n, int base = DEC)         { return print (n, base) + println (); }
+  size_t println (unsigned long n, int base = DEC){ return print (n, base) + println (); }
+  size_t println (double n, int digits = 2)       { return print (n, digits) + println (); }
+  
+  // fixed-point: eg. printFixed (1275, 2) shows 12.75
+  size_t printFixed (long n, const byte decimals = 2);
 #else
 	void write(uint8_t c) { letter(c, _invmode); }
 #endif
 
   void setInv(boolean inv) {_invmode = inv;} // set inverse mode state true == inverse
   
+  // bus speed: autotune writes test patterns to 16 columns of "page" (in the middle, so both chips
+  // are tested), reads them back, and speeds up (faster I2C clock, or shorter SPI delay) until they 
+  // don't match (or it is as fast as it goes) - then uses one step slower than the fastest speed
+  // which worked, as a margin. What was there is put back afterwards.
+  // Returns false if even the slowest speed failed. Call after begin.
+  boolean autotune (const byte page = 0);
+  void setSpeed (const unsigned long clock, const unsigned int busyDelay);   // clock 0 = leave alone, at most LCD_MAX_CLOCK
+  unsigned long busClock () const { return _busClock; }
+  unsigned int busyDelay () const { return _busyDelay; }
+  // bus faults: a transmission which fails (eg. noise on a long cable) is counted, and the pages
+  // it was writing to are marked as suspect. verify reads back "count" pages of one chip (64 bytes
+  // each - suspect ones first, then the rest in turn) and rewrites only those which don't match
+  // what was drawn. Returns how many it rewrote.
+  // It needs a copy of what was drawn: the write-through cache, or a frame (LCD_FRAME_SIZE bytes)
+  // given to setReference, which from then on is kept up to date with everything sent to the LCD.
+  // Call setReference before begin, or with a frame holding what the LCD shows (eg. the "shown" 
+  // frame given to display). Reads (eg. for setPixel) then come from the frame, not the LCD.
+  void setReference (byte * frame);
+  byte verify (byte count = 1);
+  unsigned long busErrors () const { return _busErrors; }
+  unsigned long pagesChecked () const { return _pagesChecked; }
+  unsigned long pagesRepaired () const { return _pagesRepaired; }
+  unsigned int suspectPages () const { return _suspect; }   // bit n: page (n & 7) of chip (n >> 3)
+  
+#ifdef __AVR__
+  // keep the speed in EEPROM (8 bytes at "address") - loadSpeed returns false if none was saved there
+  void saveSpeed (const int address);
+  boolean loadSpeed (const int address);
+#endif
+  
 };
 
 #endif  // I2C_graphical_LCD_display_H
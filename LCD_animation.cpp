@@ -0,0 +1,141 @@
+/*
+ LCD_animation.cpp
+
+ Delta-encoded animations from PROGMEM for I2C_graphical_LCD_display - see LCD_animation.h
+
+ Date: 19 October 2026.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_animation.h"
+
+// constructor
+LCD_animation::LCD_animation (I2C_graphical_LCD_display & lcd,
+                              const byte * data,
+                              const byte x,
+                              const byte page)
+  : _lcd (lcd), _data (data), _x (x), _page (page), _frame (0), _due (0), _lastBytes (0), _loop (true)
+{
+  _deltas = _next = &_data [LCD_ANIM_HEADER + width () * pages ()];
+  _frameTime = pgm_read_byte (&_data [4]) | (pgm_read_byte (&_data [5]) << 8);
+}  // end of LCD_animation::LCD_animation
+
+unsigned int LCD_animation::frames () const
+{
+  return pgm_read_byte (&_data [2]) | (pgm_read_byte (&_data [3]) << 8);
+}  // end of LCD_animation::frames
+
+// draw the keyframe (all of it - we don't know what was there), a page at a time, in one batch
+void LCD_animation::begin ()
+{
+  const byte * key = &_data [LCD_ANIM_HEADER];
+
+  _lcd.beginBatch ();
+  for (byte page = 0; page < pages (); page++)
+    {
+    _lcd.gotoxy (_x, (_page + page) * 8);
+    _lcd.blit (&key [page * width ()], width ());
+    }  // end of for each page
+  _lcd.endBatch ();
+
+  _lastBytes = width () * pages ();
+  _frame = 0;
+  _next = _deltas;
+  _due = millis () + _frameTime;
+}  // end of LCD_animation::begin
+
+// show the next frame when it is due
+// the one after is due a frame time after this one was due, so the rate doesn't drift - but if we
+// are more than a frame behind, the time is lost rather than rushing the next frames out
+boolean LCD_animation::service ()
+{
+  if (finished ())
+    return false;
+
+  unsigned long now = millis ();
+  if ((long) (now - _due) < 0)
+    return false;   // not yet
+
+  _due += _frameTime;
+  if ((long) (now - _due) >= 0)
+    _due = now + _frameTime;
+
+  showNext ();
+  return true;
+}  // end of LCD_animation::service
+
+// apply the next delta: each run of changed bytes goes straight from PROGMEM, with blit
+void LCD_animation::showNext ()
+{
+  if (finished ())
+    return;
+
+  const byte * p = _next;
+  _lastBytes = 0;
+
+  _lcd.beginBatch ();
+  for (byte page = pgm_read_byte (p); page != LCD_ANIM_END; page = pgm_read_byte (p))
+    {
+    byte x = pgm_read_byte (p + 1);
+    byte count = pgm_read_byte (p + 2);
+    _lcd.gotoxy (_x + x, (_page + page) * 8);
+    _lcd.blit (p + 3, count);
+    _lastBytes += count;
+    p += 3 + count;
+    }  // end of for each run
+  _lcd.endBatch ();
+
+  // the last delta goes back to the first frame
+  if (++_frame >= frames ())
+    {
+    _frame = 0;
+    _next = _deltas;
+    }
+  else
+    _next = p + 1;
+}  // end of LCD_animation::showNext
+
+// runs of changed bytes, page by page: runs less than LCD_DIFF_GAP apart are joined, as a new run
+// costs more (3 bytes here, and a gotoxy on the bus) than sending a couple of unchanged bytes
+unsigned int LCD_animation::encodeDelta (const byte * from,
+                                         const byte * to,
+                                         const byte w,
+                                         const byte pages,
+                                         byte * out)
+{
+  unsigned int size = 0;
+
+  for (byte page = 0; page < pages; page++)
+    {
+    const byte * was = &from [page * w];
+    const byte * now = &to [page * w];
+    int x = 0;
+
+    while (x < w)
+      {
+      // skip what is the same
+      if (now [x] == was [x])
+        {
+        x++;
+        continue;
+        }
+
+      // find the end of this run: stop when there are too many unchanged bytes in a row
+      int last = x;
+      for (int i = x + 1; i < w && i - last <= LCD_DIFF_GAP + 1; i++)
+        if (now [i] != was [i])
+          last = i;
+
+      out [size++] = page;
+      out [size++] = x;
+      out [size++] = last + 1 - x;
+      for ( ; x <= last; x++)
+        out [size++] = now [x];
+      }  // end of while
+    }  // end of for each page
+
+  out [size++] = LCD_ANIM_END;
+  return size;
+}  // end of LCD_animation::encodeDelta
@@ -0,0 +1,110 @@
+/*
+ LCD_animation.h
+
+ Animations stored in PROGMEM as a keyframe plus the changes from each frame to the next, for
+ I2C_graphical_LCD_display.
+
+ Date: 19 October 2026.
+
+ Only what moves is stored, and only what moves is sent: flash use and bus traffic per frame
+ depend on how much of the picture changes, not on how many frames there are. Each frame's changes
+ are runs of new bytes, sent with blit, all in one batch.
+
+ Make the container on a PC from a series of PBM files (see host/lcd_animation_tool.cpp):
+
+   lcd_animation_tool -n spinner -t 80 spin*.pbm > spinner.h
+
+ Then:
+
+   #include "spinner.h"
+
+   I2C_graphical_LCD_display lcd;
+   LCD_animation anim (lcd, spinner, 48, 2);    // at column 48, page 2
+
+   void setup ()
+     {
+     lcd.begin ();
+     anim.begin ();              // draws the first frame
+     }
+
+   void loop ()
+     {
+     anim.service ();            // the next frame, when it is due
+     }
+
+ The container (all bytes, numbers low byte first):
+
+   width, pages              size of the animation (columns, pages of 8 pixels)
+   frames (2 bytes)          number of frames
+   frame time (2 bytes)      milliseconds per frame
+   keyframe                  the first frame: width * pages bytes, page by page, like blit
+   deltas                    one for each frame after the first, then one from the last frame back
+                             to the first (so looping doesn't need the keyframe again). Each is
+                             runs of: page, x, count, then count bytes - ending with LCD_ANIM_END.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_animation_H
+#define LCD_animation_H
+
+#include "I2C_graphical_LCD_display.h"
+
+#define LCD_ANIM_HEADER  6      // bytes before the keyframe
+#define LCD_ANIM_END     0xFF   // ends a delta
+
+// room needed by encodeDelta for a delta of an animation w columns by "pages" pages
+#define LCD_ANIM_MAX_DELTA(w, pages) ((pages) * ((w) * 2 + 3) + 1)
+
+class LCD_animation
+{
+private:
+
+  I2C_graphical_LCD_display & _lcd;
+
+  const byte * _data;        // the container (PROGMEM)
+  const byte * _deltas;      // the first delta
+  const byte * _next;        // the delta to apply next
+  byte _x;                   // left-hand column on the LCD
+  byte _page;                // top page (0 to 7)
+  unsigned int _frame;       // frame shown now
+  unsigned int _frameTime;   // milliseconds
+  unsigned long _due;        // when the next frame is due (millis)
+  unsigned int _lastBytes;   // bytes sent for the last frame
+  boolean _loop;
+
+public:
+
+  // constructor
+  LCD_animation (I2C_graphical_LCD_display & lcd,
+                 const byte * data,               // the container (PROGMEM)
+                 const byte x = 0,                // left-hand column
+                 const byte page = 0);            // top page (0 to 7)
+
+  void begin ();                  // draw the first frame, and start timing
+  boolean service ();             // show the next frame, if it is due - true if it did
+  void showNext ();               // show the next frame now
+
+  void setFrameTime (const unsigned int ms) { _frameTime = ms; }   // instead of the container's
+  void setLoop (const boolean loop) { _loop = loop; }              // false: stop at the last frame
+
+  unsigned int frame () const { return _frame; }
+  unsigned int frames () const;
+  boolean finished () const { return !_loop && _frame + 1 >= frames (); }
+  unsigned int lastBytes () const { return _lastBytes; }           // data bytes sent for the last frame
+
+  byte width () const { return pgm_read_byte (&_data [0]); }
+  byte pages () const { return pgm_read_byte (&_data [1]); }
+
+  // the delta from one frame to the next (each width * pages bytes, page by page, in RAM):
+  // out needs LCD_ANIM_MAX_DELTA (w, pages) bytes - returns the size used
+  static unsigned int encodeDelta (const byte * from,
+                                   const byte * to,
+                                   const byte w,
+                                   const byte pages,
+                                   byte * out);
+
+};
+
+#endif  // LCD_animation_H
@@ -0,0 +1,213 @@
+/*
+ LCD_big_number.cpp
+
+ Large-digit numeric readout for I2C_graphical_LCD_display - see LCD_big_number.h
+
+ Date: 19 October 2026.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_big_number.h"
+
+// The glyphs we can show: 0 to 9, minus, decimal point and space.
+// These are the same as the 5 x 8 font in I2C_graphical_LCD_display.cpp. This copy is only
+// used by the compiler to work out the big tables below - it doesn't take up any memory.
+
+#define BIG_MINUS  10
+#define BIG_POINT  11
+#define BIG_SPACE  12
+#define BIG_GLYPHS 13
+
+static constexpr byte bigSource [BIG_GLYPHS] [5] = {
+  { 0x3E, 0x51, 0x49, 0x45, 0x3E }, // 0
+  { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // 1
+  { 0x42, 0x61, 0x51, 0x49, 0x46 }, // 2
+  { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // 3
+  { 0x18, 0x14, 0x12, 0x7F, 0x10 }, // 4
+  { 0x27, 0x45, 0x45, 0x45, 0x39 }, // 5
+  { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, // 6
+  { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 7
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, // 8
+  { 0x06, 0x49, 0x49, 0x29, 0x1E }, // 9
+  { 0x08, 0x08, 0x08, 0x08, 0x08 }, // -
+  { 0x00, 0x30, 0x30, 0x00, 0x00 }, // .
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+};
+
+// One byte (page) of a scaled-up column: bit n of the result comes from
+// source row (page * 8 + n) / scale. Worked out by the compiler, one bit at a time.
+static constexpr byte bigBits (const byte source,
+                               const byte scale,
+                               const byte page,
+                               const byte bit)
+{
+  return bit > 7 ? 0 :
+         (((source >> ((page * 8 + bit) / scale)) & 1) << bit) | bigBits (source, scale, page, bit + 1);
+}  // end of bigBits
+
+#define BIG_BYTE(g, s, p, c) bigBits (bigSource [g] [(c) / (s)], s, p, 0)
+
+#define BIG_COLS_10(g, s, p) \
+  BIG_BYTE (g, s, p, 0), BIG_BYTE (g, s, p, 1), BIG_BYTE (g, s, p, 2), BIG_BYTE (g, s, p, 3), \
+  BIG_BYTE (g, s, p, 4), BIG_BYTE (g, s, p, 5), BIG_BYTE (g, s, p, 6), BIG_BYTE (g, s, p, 7), \
+  BIG_BYTE (g, s, p, 8), BIG_BYTE (g, s, p, 9)
+
+#define BIG_COLS_15(g, s, p) \
+  BIG_COLS_10 (g, s, p), \
+  BIG_BYTE (g, s, p, 10), BIG_BYTE (g, s, p, 11), BIG_BYTE (g, s, p, 12), BIG_BYTE (g, s, p, 13), \
+  BIG_BYTE (g, s, p, 14)
+
+#define BIG_GLYPH_16(g) { { BIG_COLS_10 (g, 2, 0) }, { BIG_COLS_10 (g, 2, 1) } }
+#define BIG_GLYPH_24(g) { { BIG_COLS_15 (g, 3, 0) }, { BIG_COLS_15 (g, 3, 1) }, { BIG_COLS_15 (g, 3, 2) } }
+
+// 16 pixels high: 10 columns by 2 pages per glyph
+const byte bigFont16 [BIG_GLYPHS] [2] [10] PROGMEM = {
+  BIG_GLYPH_16 (0),  BIG_GLYPH_16 (1),  BIG_GLYPH_16 (2),  BIG_GLYPH_16 (3),
+  BIG_GLYPH_16 (4),  BIG_GLYPH_16 (5),  BIG_GLYPH_16 (6),  BIG_GLYPH_16 (7),
+  BIG_GLYPH_16 (8),  BIG_GLYPH_16 (9),  BIG_GLYPH_16 (10), BIG_GLYPH_16 (11),
+  BIG_GLYPH_16 (12),
+};
+
+// 24 pixels high: 15 columns by 3 pages per glyph
+const byte bigFont24 [BIG_GLYPHS] [3] [15] PROGMEM = {
+  BIG_GLYPH_24 (0),  BIG_GLYPH_24 (1),  BIG_GLYPH_24 (2),  BIG_GLYPH_24 (3),
+  BIG_GLYPH_24 (4),  BIG_GLYPH_24 (5),  BIG_GLYPH_24 (6),  BIG_GLYPH_24 (7),
+  BIG_GLYPH_24 (8),  BIG_GLYPH_24 (9),  BIG_GLYPH_24 (10), BIG_GLYPH_24 (11),
+  BIG_GLYPH_24 (12),
+};
+
+// constructor
+LCD_big_number::LCD_big_number (I2C_graphical_LCD_display & lcd,
+                                const byte x,
+                                const byte y,
+                                const byte digits,
+                                const byte height,
+                                const byte decimals)
+  : _lcd (lcd), _x (x), _y (y & ~7), _digits (digits), _decimals (decimals)
+{
+  _scale = height >= 24 ? 3 : 2;
+  if (_digits == 0)
+    _digits = 1;
+  // room for the decimal point as well
+  if (_digits + (_decimals ? 1 : 0) > LCD_BIG_MAX_DIGITS)
+    _digits = LCD_BIG_MAX_DIGITS - (_decimals ? 1 : 0);
+  if (_decimals >= _digits)
+    _decimals = _digits - 1;
+  invalidate ();
+}  // end of LCD_big_number::LCD_big_number
+
+// forget what is on the screen, so that every position is drawn next time
+void LCD_big_number::invalidate ()
+{
+  memset (_shown, 0, sizeof _shown);
+}  // end of LCD_big_number::invalidate
+
+// digits are 6 x scale wide (including the gap), the decimal point is 3 x scale
+unsigned int LCD_big_number::cellX (const byte cell) const
+{
+  byte pointCell = _digits - _decimals;
+  if (_decimals && cell > pointCell)
+    return _x + (cell - 1) * 6 * _scale + 3 * _scale;
+  return _x + cell * 6 * _scale;
+}  // end of LCD_big_number::cellX
+
+byte LCD_big_number::width () const
+{
+  return cellX (_digits + (_decimals ? 1 : 0)) - _x;
+}  // end of LCD_big_number::width
+
+// draw one digit position, all of its pages in one batch
+void LCD_big_number::drawCell (const byte cell,
+                               const char c)
+{
+  byte glyph;
+  if (c >= '0' && c <= '9')
+    glyph = c - '0';
+  else if (c == '-')
+    glyph = BIG_MINUS;
+  else if (c == '.')
+    glyph = BIG_POINT;
+  else
+    glyph = BIG_SPACE;
+
+  byte glyphWidth = 5 * _scale;
+  const byte * bitmap = _scale == 3 ? &bigFont24 [glyph] [0] [0] : &bigFont16 [glyph] [0] [0];
+
+  // the decimal point only uses columns 1 and 2 of the font
+  byte first = 0, last = glyphWidth;
+  if (glyph == BIG_POINT)
+    {
+    first = _scale;
+    last = 3 * _scale;
+    }
+
+  // clip at the right-hand side and the bottom, rather than wrapping round
+  unsigned int left = cellX (cell);
+  unsigned int right = _lcd.width ();
+  if (left >= right)
+    return;
+
+  _lcd.beginBatch ();
+  for (byte page = 0; page < _scale && _y + page * 8 < _lcd.height (); page++)
+    {
+    unsigned int column = left;
+    _lcd.gotoxy (left, _y + page * 8);
+    for (byte x = first; x < last && column < right; x++, column++)
+      _lcd.writeData (pgm_read_byte (&bitmap [page * glyphWidth + x]));
+    for (byte x = 0; x < _scale && column < right; x++, column++)
+      _lcd.writeData (0);   // gap between digits
+    }  // end of for each page
+  _lcd.endBatch ();
+}  // end of LCD_big_number::drawCell
+
+// show a number, right-aligned, with _decimals implied decimal places
+// (eg. with 2 decimals, 1275 shows as 12.75)
+void LCD_big_number::setNumber (long value)
+{
+  char now [LCD_BIG_MAX_DIGITS];
+  byte cells = _digits + (_decimals ? 1 : 0);
+  byte pointCell = _digits - _decimals;
+  boolean negative = value < 0;
+  unsigned long n = negative ? - (unsigned long) value : value;
+
+  // fill in from the right: all the decimals, and at least one digit before the point
+  int cell = cells - 1;
+  byte done = 0;
+  while (cell >= 0)
+    {
+    if (_decimals && cell == pointCell)
+      now [cell--] = '.';
+    else if (n || done <= _decimals)
+      {
+      now [cell--] = '0' + n % 10;
+      n /= 10;
+      done++;
+      }
+    else
+      break;
+    }  // end of while
+
+  if (n || (negative && cell < 0))
+    {
+    // doesn't fit
+    for (cell = 0; cell < cells; cell++)
+      now [cell] = (_decimals && cell == pointCell) ? '.' : '-';
+    }
+  else
+    {
+    if (negative)
+      now [cell--] = '-';
+    while (cell >= 0)
+      now [cell--] = ' ';
+    }
+
+  // only send the positions which changed
+  for (cell = 0; cell < cells; cell++)
+    if (now [cell] != _shown [cell])
+      {
+      drawCell (cell, now [cell]);
+      _shown [cell] = now [cell];
+      }
+}  // end of LCD_big_number::setNumber
@@ -0,0 +1,69 @@
+/*
+ LCD_big_number.h
+
+ Large-digit numeric readout (16 or 24 pixels high) for I2C_graphical_LCD_display.
+
+ Date: 19 October 2026.
+
+ The digit bitmaps are the 5 x 8 font digits scaled up 2 or 3 times. The scaling is
+ done by the compiler, so the tables just sit in PROGMEM, ready to send.
+
+ The readout remembers what each digit position showed last time, so setNumber only
+ sends the digits which changed - each one as a single batch covering all its pages.
+
+ Example:
+
+   I2C_graphical_LCD_display lcd;
+   LCD_big_number rpm (lcd, 0, 16, 5);             // 5 digits, 16 pixels high, at 0,16
+   LCD_big_number volts (lcd, 0, 40, 4, 24, 2);    // 4 digits, 24 pixels high, 2 decimals
+
+   lcd.begin ();
+   rpm.setNumber (1234);       // shows " 1234"
+   volts.setNumber (1275);     // shows "12.75"
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_big_number_H
+#define LCD_big_number_H
+
+#include "I2C_graphical_LCD_display.h"
+
+#define LCD_BIG_MAX_DIGITS 10   // most digit positions in one readout (RAM use is one byte each)
+
+class LCD_big_number
+{
+private:
+
+  I2C_graphical_LCD_display & _lcd;
+
+  byte _x;          // left-hand column
+  byte _y;          // top row (a multiple of 8)
+  byte _digits;     // digit positions (including one for a minus sign, if wanted)
+  byte _scale;      // 2 = 16 pixels high, 3 = 24 pixels high
+  byte _decimals;   // digits after the decimal point
+
+  char _shown [LCD_BIG_MAX_DIGITS];   // what each position shows now (0 = unknown)
+
+  void drawCell (const byte cell, const char c);
+  unsigned int cellX (const byte cell) const;   // may be past the right-hand side
+
+public:
+
+  // constructor
+  LCD_big_number (I2C_graphical_LCD_display & lcd,
+                  const byte x,                // left-hand column
+                  const byte y,                // top row (forced to a multiple of 8)
+                  const byte digits,           // digit positions
+                  const byte height = 16,      // 16 or 24 pixels
+                  const byte decimals = 0);    // implied decimal places in setNumber
+
+  void setNumber (long value);   // right-aligned; shows dashes if it doesn't fit
+  void invalidate ();            // draw every digit next time (eg. after lcd.clear)
+
+  byte width () const;           // in pixels (digits past the edge of the screen are clipped)
+
+};
+
+#endif  // LCD_big_number_H
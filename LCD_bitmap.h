@@ -0,0 +1,134 @@
+/*
+ LCD_bitmap.h
+
+ Bitmaps for I2C_graphical_LCD_display, drawn the way you see them, and converted to the LCD's
+ layout (pages of column bytes, LSB at the top) by the compiler.
+
+ Date: 19 October 2026.
+
+ There is nothing to link in: the result is an ordinary PROGMEM array, exactly as if it had been
+ typed in by hand, plus its width and height. No RAM, and no time spent converting when it runs.
+
+ ASCII art - one character per pixel, rows one after another. '.', ' ', '_' and '0' are
+ white, anything else is black:
+
+   LCD_BITMAP (face, 8, 8,
+     "..####.."
+     ".#....#."
+     "#.#..#.#"
+     "#......#"
+     "#.#..#.#"
+     "#..##..#"
+     ".#....#."
+     "..####..");
+
+ Or bytes, a row at a time, leftmost pixel in the high bit of the first byte (as in PBM or XBM files
+ - but unlike XBM, 1 = black), with each row rounded up to a whole number of bytes:
+
+   LCD_BITMAP_ROWS (arrow, 5, 3, 0x20, 0xF0, 0x20);
+
+ Either way you get:
+
+   face                 - the bitmap (PROGMEM), page by page: ((height + 7) / 8) * width bytes
+   face_width           - 8
+   face_height          - 8
+
+   lcd.bitmap (x, y, face, face_width, face_height);   // any y, not just multiples of 8
+
+ Bitmaps which are a multiple of 8 pixels high can also be used with blit, a page at a time.
+
+ Needs C++11 (Arduino IDE 1.6.6 onwards).
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_bitmap_H
+#define LCD_bitmap_H
+
+#include "I2C_graphical_LCD_display.h"
+
+// a list of numbers 0, 1 ... N - 1, as template arguments (like std::index_sequence, which
+// the AVR compiler doesn't have). The list is made by joining two halves, so the template
+// nesting is only log2 (N) deep, rather than N (which would hit the compiler's limit).
+
+template <unsigned... I> struct LCD_indices {};
+
+template <typename A, typename B> struct LCD_join_indices;
+
+template <unsigned... A, unsigned... B>
+struct LCD_join_indices <LCD_indices <A...>, LCD_indices <B...> >
+{
+  typedef LCD_indices <A..., (sizeof... (A) + B)...> type;
+};
+
+template <unsigned N>
+struct LCD_make_indices
+{
+  typedef typename LCD_join_indices <typename LCD_make_indices <N / 2>::type,
+                                     typename LCD_make_indices <N - N / 2>::type>::type type;
+};
+
+template <> struct LCD_make_indices <0> { typedef LCD_indices <> type; };
+template <> struct LCD_make_indices <1> { typedef LCD_indices <0> type; };
+
+// one column byte: bit n is the pixel at row (page * 8 + n), if that is inside the bitmap
+template <typename Source>
+constexpr byte LCD_bitmap_byte (const unsigned page,
+                                const unsigned x,
+                                const unsigned bit)
+{
+  return bit > 7 ? 0 :
+         ((page * 8 + bit < Source::height && Source::pixel (x, page * 8 + bit)) ? (1 << bit) : 0) |
+         LCD_bitmap_byte <Source> (page, x, bit + 1);
+}  // end of LCD_bitmap_byte
+
+// the bitmap itself: byte I is column (I % width) of page (I / width)
+template <typename Source, typename Indices> struct LCD_bitmap_pages;
+
+template <typename Source, unsigned... I>
+struct LCD_bitmap_pages <Source, LCD_indices <I...> >
+{
+  static constexpr byte data [sizeof... (I)] PROGMEM =
+    { LCD_bitmap_byte <Source> (I / Source::width, I % Source::width, 0)... };
+};
+
+template <typename Source, unsigned... I>
+constexpr byte LCD_bitmap_pages <Source, LCD_indices <I...> >::data [sizeof... (I)];
+
+// what the macros below make
+#define LCD_BITMAP_DEFINE(name, w, h) \
+  const byte name##_width = (w); \
+  const byte name##_height = (h); \
+  constexpr const byte (& name) [((h) + 7) / 8 * (w)] = \
+    LCD_bitmap_pages <name##_source, LCD_make_indices <((h) + 7) / 8 * (w)>::type>::data
+
+// ASCII art
+constexpr bool LCD_bitmap_black (const char c)
+{
+  return c != '.' && c != ' ' && c != '_' && c != '0';
+}  // end of LCD_bitmap_black
+
+#define LCD_BITMAP(name, w, h, art) \
+  static_assert (sizeof (art) == (w) * (h) + 1, "LCD_BITMAP " #name ": art must be width x height characters"); \
+  struct name##_source \
+    { \
+    static constexpr unsigned width = (w), height = (h); \
+    static constexpr bool pixel (const unsigned x, const unsigned y) \
+      { return LCD_bitmap_black (art [y * width + x]); } \
+    }; \
+  LCD_BITMAP_DEFINE (name, w, h)
+
+// bytes, a row at a time
+template <unsigned N> struct LCD_bitmap_bytes { byte b [N]; };
+
+#define LCD_BITMAP_ROWS(name, w, h, ...) \
+  struct name##_source \
+    { \
+    static constexpr unsigned width = (w), height = (h), stride = ((w) + 7) / 8; \
+    static constexpr bool pixel (const unsigned x, const unsigned y) \
+      { return (LCD_bitmap_bytes <stride * height> { { __VA_ARGS__ } }.b [y * stride + x / 8] >> (7 - x % 8)) & 1; } \
+    }; \
+  LCD_BITMAP_DEFINE (name, w, h)
+
+#endif  // LCD_bitmap_H
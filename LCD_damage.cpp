@@ -0,0 +1,165 @@
+/*
+ LCD_damage.cpp
+
+ Priority-ordered updates for I2C_graphical_LCD_display - see LCD_damage.h
+
+ Date: 19 October 2026.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_damage.h"
+
+// constructor
+LCD_damage::LCD_damage (I2C_graphical_LCD_display & lcd,
+                        const byte * frame,
+                        byte * shown)
+  : _lcd (lcd), _frame (frame), _shown (shown), _count (0), _current (LCD_DAMAGE_MAX)
+{
+  resetStats ();
+}  // end of LCD_damage::LCD_damage
+
+void LCD_damage::resetStats ()
+{
+  memset (&_stats, 0, sizeof _stats);
+}  // end of LCD_damage::resetStats
+
+// should region a be sent before region b?
+// higher priority first, then the earlier deadline (one with a deadline before one without)
+boolean LCD_damage::before (const Region & a,
+                            const Region & b) const
+{
+  if (a.priority != b.priority)
+    return a.priority > b.priority;
+  if (!a.hasDeadline)
+    return false;
+  return !b.hasDeadline || (long) (a.due - b.due) < 0;
+}  // end of LCD_damage::before
+
+// the region to send next: ties go to the one damaged first
+byte LCD_damage::next () const
+{
+  byte best = 0;
+  for (byte i = 1; i < _count; i++)
+    if (before (_regions [i], _regions [best]))
+      best = i;
+  return best;
+}  // end of LCD_damage::next
+
+void LCD_damage::remove (const byte i)
+{
+  memmove (&_regions [i], &_regions [i + 1], (_count - i - 1) * sizeof (Region));
+  _count--;
+  if (_current == i)
+    _current = LCD_DAMAGE_MAX;
+  else if (_current > i && _current < LCD_DAMAGE_MAX)
+    _current--;
+}  // end of LCD_damage::remove
+
+void LCD_damage::damage (const byte x1,
+                         const byte y1,
+                         byte x2,
+                         byte y2,
+                         const byte priority,
+                         const unsigned int deadline)
+{
+  // portrait frames are 64 x 128
+  boolean portrait = _lcd.rotation () & 1;
+  if (x2 > (portrait ? 63 : 127))
+    x2 = portrait ? 63 : 127;
+  if (y2 > (portrait ? 127 : 63))
+    y2 = portrait ? 127 : 63;
+  if (x1 > x2 || y1 > y2)
+    return;
+
+  Region r;
+  r.x1 = x1;
+  r.x2 = x2;
+  r.page = y1 >> 3;
+  r.page2 = y2 >> 3;
+  r.priority = priority;
+  r.hasDeadline = deadline != 0;
+  r.due = millis () + deadline;
+
+  // join onto a region of the same priority which it overlaps or touches
+  // if there is no room, join onto the one which would go last (it then goes as soon as either would)
+  byte i;
+  for (i = 0; i < _count; i++)
+    {
+    const Region & old = _regions [i];
+    if (old.priority == priority &&
+        x1 <= old.x2 + 1 && old.x1 <= x2 + 1 &&
+        r.page <= old.page2 + 1 && old.page <= r.page2 + 1)
+      break;
+    }
+
+  if (i == _count && _count == LCD_DAMAGE_MAX)
+    {
+    i = 0;
+    for (byte j = 1; j < _count; j++)
+      if (before (_regions [i], _regions [j]))
+        i = j;
+    _stats.merged++;
+    }
+
+  if (i == _count)
+    {
+    _regions [_count++] = r;
+    return;
+    }
+
+  Region & old = _regions [i];
+  if (r.x1 < old.x1)
+    old.x1 = r.x1;
+  if (r.x2 > old.x2)
+    old.x2 = r.x2;
+  if (r.page < old.page)
+    old.page = r.page;
+  if (r.page2 > old.page2)
+    old.page2 = r.page2;
+  if (r.priority > old.priority)
+    old.priority = r.priority;
+  if (r.hasDeadline && (!old.hasDeadline || (long) (r.due - old.due) < 0))
+    {
+    old.hasDeadline = true;
+    old.due = r.due;
+    }
+}  // end of LCD_damage::damage
+
+// send page runs, the most urgent first (choosing again after each page), until there are none
+// left or the budget is used up
+boolean LCD_damage::flush (const unsigned long budget)
+{
+  unsigned long start = micros ();
+
+  while (_count)
+    {
+    byte i = next ();
+    if (_current < LCD_DAMAGE_MAX && i != _current)
+      _stats.preempted++;   // the one we were sending has to wait
+
+    Region & r = _regions [i];
+    _lcd.display (_frame, _shown, r.x1, r.page, r.x2, r.page);
+    _stats.pages++;
+    _current = i;
+
+    if (r.page++ >= r.page2)
+      {
+      // all sent - in time?
+      if (r.hasDeadline && (long) (millis () - r.due) > 0)
+        {
+        _stats.missed++;
+        if (millis () - r.due > _stats.worstLate)
+          _stats.worstLate = millis () - r.due;
+        }
+      _stats.regions++;
+      remove (i);
+      }
+
+    if (budget && micros () - start >= budget)
+      break;
+    }  // end of while
+
+  return _count == 0;
+}  // end of LCD_damage::flush
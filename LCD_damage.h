@@ -0,0 +1,108 @@
+/*
+ LCD_damage.h
+
+ Priority-ordered updates for I2C_graphical_LCD_display: draw into a frame buffer, say which parts
+ of it changed ("damage" them) and how urgent they are, and flush sends the most urgent first.
+
+ Date: 19 October 2026.
+
+ Each damaged region has a priority (higher goes first) and, optionally, a deadline (milliseconds
+ from when it was damaged). flush sends one page of one region at a time, and after every page
+ picks again: so if an alarm banner is damaged while a full-screen redraw is being flushed, the
+ redraw stops at the end of the page it is on, the banner goes, and then the redraw carries on
+ where it left off. With a time budget, flush returns when the budget is used up, so it can be
+ called from loop without holding anything else up - the wait for an urgent region is then
+ at most one page (about 128 bytes) of whatever is being sent.
+
+ Equal priorities go earliest deadline first, then in the order they were damaged.
+
+ If "shown" is given (a copy of what the LCD shows, see display) only the bytes which changed are
+ sent, so overlapping regions cost nothing extra.
+
+ Example:
+
+   I2C_graphical_LCD_display lcd;
+   byte frame [LCD_FRAME_SIZE];
+   LCD_damage damage (lcd, frame);
+
+   lcd.setTarget (frame);
+   ...                                          // draw the whole screen
+   damage.damage (0, 0, 127, 63);               // priority 0, no deadline
+   ...
+   lcd.clear (0, 0, 127, 7, 0xFF);              // alarm banner
+   damage.damage (0, 0, 127, 7, 200, 50);       // priority 200, on the LCD within 50 ms
+   ...
+   damage.flush (2000);                         // in loop: send for up to 2 ms
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_damage_H
+#define LCD_damage_H
+
+#include "I2C_graphical_LCD_display.h"
+
+#define LCD_DAMAGE_MAX  8   // regions waiting at once (more are merged) - 10 bytes of RAM each
+
+class LCD_damage
+{
+public:
+
+  struct Stats
+    {
+    unsigned long regions;        // regions completely sent
+    unsigned long pages;          // page runs sent
+    unsigned long preempted;      // times a region was left part-sent for a more urgent one
+    unsigned long merged;         // regions merged into another, as the queue was full
+    unsigned long missed;         // regions finished after their deadline
+    unsigned long worstLate;      // most a region was finished after its deadline (milliseconds)
+    };
+
+  // constructor
+  LCD_damage (I2C_graphical_LCD_display & lcd,
+              const byte * frame,                // LCD_FRAME_SIZE bytes, drawn into with setTarget
+              byte * shown = NULL);              // what the LCD shows (LCD_FRAME_SIZE bytes), or NULL
+
+  // x1,y1 to x2,y2 (inclusive) of the frame changed - y is rounded out to whole pages
+  void damage (const byte x1,
+               const byte y1,
+               byte x2,
+               byte y2,
+               const byte priority = 0,
+               const unsigned int deadline = 0);   // milliseconds from now (0 = none)
+
+  boolean flush (const unsigned long budget = 0);    // microseconds (0 = no limit) - true if all sent
+  byte pending () const { return _count; }           // regions not sent yet
+
+  const Stats & stats () const { return _stats; }
+  void resetStats ();
+
+private:
+
+  struct Region
+    {
+    byte x1, x2;              // columns
+    byte page, page2;         // next page to send, last page
+    byte priority;
+    boolean hasDeadline;
+    unsigned long due;        // deadline (millis)
+    };
+
+  I2C_graphical_LCD_display & _lcd;
+  const byte * _frame;
+  byte * _shown;
+
+  Region _regions [LCD_DAMAGE_MAX];   // in the order they were damaged
+  byte _count;
+  byte _current;                      // region flush was sending last (LCD_DAMAGE_MAX = none)
+
+  Stats _stats;
+
+  boolean before (const Region & a, const Region & b) const;
+  byte next () const;
+  void remove (const byte i);
+
+};
+
+#endif  // LCD_damage_H
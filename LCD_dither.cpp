@@ -0,0 +1,125 @@
+/*
+ LCD_dither.cpp
+
+ Grayscale images for I2C_graphical_LCD_display - see LCD_dither.h
+
+ Date: 19 October 2026.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_dither.h"
+
+// 8 x 8 Bayer matrix (0 to 63)
+const byte bayer8 [8] [8] PROGMEM = {
+  {  0, 32,  8, 40,  2, 34, 10, 42 },
+  { 48, 16, 56, 24, 50, 18, 58, 26 },
+  { 12, 44,  4, 36, 14, 46,  6, 38 },
+  { 60, 28, 52, 20, 62, 30, 54, 22 },
+  {  3, 35, 11, 43,  1, 33,  9, 41 },
+  { 51, 19, 59, 27, 49, 17, 57, 25 },
+  { 15, 47,  7, 39, 13, 45,  5, 37 },
+  { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+// constructor
+LCD_dither::LCD_dither (I2C_graphical_LCD_display & lcd,
+                        const byte x,
+                        const byte page,
+                        const byte width,
+                        const byte method)
+  : _lcd (lcd), _x (x), _page (page), _width (width), _method (method)
+{
+  // keep everything on the screen, and within our buffers
+  if (_x > 127)
+    _x = 127;
+  if (_width > LCD_DITHER_MAX_WIDTH)
+    _width = LCD_DITHER_MAX_WIDTH;
+  if (_width > 128 - _x)
+    _width = 128 - _x;
+  if (_page > 7)
+    _page = 7;
+  begin ();
+}  // end of LCD_dither::LCD_dither
+
+void LCD_dither::begin ()
+{
+  _row = 0;
+  memset (_bits, 0, sizeof _bits);
+  memset (_error, 0, sizeof _error);
+}  // end of LCD_dither::begin
+
+// one row of the image: work out its pixels, and put them into the page being built up
+void LCD_dither::addRow (const byte * gray)
+{
+  if (_page + (_row >> 3) > 7)
+    return;   // off the bottom of the screen
+
+  byte mask = 1 << (_row & 7);
+
+  switch (_method)
+    {
+    case LCD_DITHER_FLOYD:
+      {
+      // Each pixel's error is shared out: 7/16 to the right, and 3/16, 5/16, 1/16 below left,
+      // below, and below right. _error holds what this row was given by the row above. As we go
+      // along, it is replaced by what the next row gets - except that the part for below right
+      // can't go in yet (this row still needs that element), so it waits in "pending".
+      int right = 0, pending = 0;
+      for (byte x = 0; x < _width; x++)
+        {
+        int value = gray [x] + _error [x] + right;
+        int error;
+        if (value < 128)
+          {
+          _bits [x] |= mask;      // black
+          error = value;
+          }
+        else
+          error = value - 255;   // white
+
+        right = (error * 7) / 16;
+        if (x > 0)
+          _error [x - 1] += (error * 3) / 16;
+        _error [x] = (error * 5) / 16 + pending;
+        pending = error / 16;
+        }  // end of for each pixel
+      }
+      break;
+
+    case LCD_DITHER_BAYER:
+      {
+      const byte * thresholds = bayer8 [_row & 7];
+      for (byte x = 0; x < _width; x++)
+        if (gray [x] < pgm_read_byte (&thresholds [x & 7]) * 4 + 2)
+          _bits [x] |= mask;
+      }
+      break;
+
+    default:
+      for (byte x = 0; x < _width; x++)
+        if (gray [x] < 128)
+          _bits [x] |= mask;
+      break;
+    }  // end of switch
+
+  // finished a page?
+  if ((++_row & 7) == 0)
+    sendPage ();
+}  // end of LCD_dither::addRow
+
+void LCD_dither::end ()
+{
+  if (_row & 7)
+    sendPage ();
+  _row = (_row + 7) & ~7;   // in case more rows follow
+}  // end of LCD_dither::end
+
+// send the finished page (in one batch), and start the next one
+void LCD_dither::sendPage ()
+{
+  _lcd.gotoxy (_x, (_page + ((_row - 1) >> 3)) * 8);
+  _lcd.writeRun (_bits, _width);
+  memset (_bits, 0, sizeof _bits);
+}  // end of LCD_dither::sendPage
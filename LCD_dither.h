@@ -0,0 +1,85 @@
+/*
+ LCD_dither.h
+
+ Shows 8-bit grayscale images (eg. camera thumbnails) on I2C_graphical_LCD_display, by dithering
+ them to black and white as they arrive, a row at a time.
+
+ Date: 19 October 2026.
+
+ Rows are given to addRow one at a time (0 = black, 255 = white). Every 8 rows make a page, which
+ is sent to the LCD as a single batch, so the whole grayscale image is never held in memory - just
+ one page of output and (for Floyd-Steinberg) one row of errors.
+
+ Dithering methods:
+   LCD_DITHER_FLOYD     - Floyd-Steinberg error diffusion: best for photos
+   LCD_DITHER_BAYER     - 8 x 8 ordered dither: a regular pattern, better for graphs and moving images
+                          (a pixel only depends on its own value, so it doesn't "crawl" between frames)
+   LCD_DITHER_THRESHOLD - just black below 128, white above
+
+ Example:
+
+   I2C_graphical_LCD_display lcd;
+   LCD_dither dither (lcd);              // full screen, Floyd-Steinberg
+
+   lcd.begin ();
+   dither.begin ();
+   for (byte y = 0; y < 64; y++)
+     {
+     byte row [128];
+     ...                                 // get a row from the camera
+     dither.addRow (row);
+     }
+   dither.end ();                        // only needed if the height isn't a multiple of 8
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_dither_H
+#define LCD_dither_H
+
+#include "I2C_graphical_LCD_display.h"
+
+#define LCD_DITHER_MAX_WIDTH 128   // RAM used is about 3 bytes per column - reduce for narrower images
+
+// dithering methods
+
+#define LCD_DITHER_FLOYD      0
+#define LCD_DITHER_BAYER      1
+#define LCD_DITHER_THRESHOLD  2
+
+class LCD_dither
+{
+private:
+
+  I2C_graphical_LCD_display & _lcd;
+
+  byte _x;          // left-hand column on the LCD
+  byte _page;       // top page (0 to 7)
+  byte _width;      // columns in the image
+  byte _method;     // LCD_DITHER_FLOYD etc.
+
+  byte _row;        // rows done so far
+  byte _bits [LCD_DITHER_MAX_WIDTH];    // the page being built up
+  int _error [LCD_DITHER_MAX_WIDTH];    // Floyd-Steinberg: error carried to the next row
+
+  void sendPage ();
+
+public:
+
+  // constructor
+  LCD_dither (I2C_graphical_LCD_display & lcd,
+              const byte x = 0,                         // left-hand column
+              const byte page = 0,                      // top page (0 to 7)
+              const byte width = 128,                   // pixels in each row
+              const byte method = LCD_DITHER_FLOYD);
+
+  void setMethod (const byte method) { _method = method; }
+
+  void begin ();                     // start a new image (at the top)
+  void addRow (const byte * gray);   // width pixels, 0 = black, 255 = white
+  void end ();                       // send a partly-finished page (the rest of it is white)
+
+};
+
+#endif  // LCD_dither_H
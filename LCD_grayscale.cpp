@@ -0,0 +1,240 @@
+/*
+ LCD_grayscale.cpp
+
+ Four grey levels by temporal dithering, for I2C_graphical_LCD_display - see LCD_grayscale.h
+
+ Date: 19 October 2026.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_grayscale.h"
+
+// rows of a page byte, by row number mod 3 (rows 0, 3, 6 - rows 1, 4, 7 - rows 2, 5)
+static const byte grayRows [3] = { 0x49, 0x92, 0x24 };
+
+// constructor
+LCD_grayscale::LCD_grayscale (I2C_graphical_LCD_display & lcd,
+                              byte * planes,
+                              const byte x,
+                              const byte page,
+                              const byte width,
+                              const byte pages)
+  : _lcd (lcd), _planes (planes), _x (x), _page (page), _width (width), _pages (pages)
+{
+  // keep everything on the screen
+  if (_x > 127)
+    _x = 127;
+  if (_width > 128 - _x)
+    _width = 128 - _x;
+  if (_width == 0)
+    _width = 1;
+  if (_page > 7)
+    _page = 7;
+  if (_pages > 8 - _page)
+    _pages = 8 - _page;
+  if (_pages == 0)
+    _pages = 1;
+
+  _frame = 0;
+  memset (_dirty, 0, sizeof _dirty);
+  setRate (60);
+  _due = 0;
+  resetStats ();
+}  // end of LCD_grayscale::LCD_grayscale
+
+// clear to white: everything is sent by the next service, as we don't know what the LCD shows
+void LCD_grayscale::begin (const unsigned int rate)
+{
+  clear (LCD_GRAY_WHITE);
+  _frame = 0;
+  setRate (rate);
+  _due = micros ();
+  resetStats ();
+}  // end of LCD_grayscale::begin
+
+void LCD_grayscale::setRate (unsigned int rate)
+{
+  if (rate == 0)
+    rate = 1;
+  _period = 1000000UL / rate;
+}  // end of LCD_grayscale::setRate
+
+void LCD_grayscale::resetStats ()
+{
+  memset (&_stats, 0, sizeof _stats);
+}  // end of LCD_grayscale::resetStats
+
+// send the next frame if it is due
+// the next one is then due one period after this one was due (not after it was sent), so the
+// rate doesn't drift - unless we are a whole frame or more behind, when those frames are skipped
+boolean LCD_grayscale::service ()
+{
+  unsigned long now = micros ();
+  if ((long) (now - _due) < 0)
+    return false;   // not yet
+
+  unsigned long late = now - _due;
+  if (late > _stats.longestLate)
+    _stats.longestLate = late;
+  _stats.missed += late / _period;
+  _due += (late / _period + 1) * _period;
+
+  flip ();
+  return true;
+}  // end of LCD_grayscale::service
+
+// one byte of frame 0, 1 or 2 (x and page are in the area)
+// a pixel's place in the cycle is (x + y) mod 3: black in frame f if (f + place) mod 3 < level
+byte LCD_grayscale::frameByte (const byte frame,
+                               const byte x,
+                               const byte page) const
+{
+  unsigned int i = page * _width + x;
+  byte lo = _planes [i];
+  byte hi = _planes [_pages * _width + i];
+  byte top = (x + page * 8) % 3;   // place of the top row of this byte
+
+  // light grey: black when the place is -frame (mod 3) - dark grey: except when it is 2 - frame
+  return (hi & lo) |
+         (lo & ~hi & grayRows [(6 - frame - top) % 3]) |
+         (hi & ~lo & ~grayRows [(8 - frame - top) % 3]);
+}  // end of LCD_grayscale::frameByte
+
+// columns x1 to x2 of a page have been drawn on
+void LCD_grayscale::touch (const byte page,
+                           const byte x1,
+                           const byte x2)
+{
+  for (byte block = x1 >> 3; block <= x2 >> 3; block++)
+    _dirty [page] |= 1U << block;
+}  // end of LCD_grayscale::touch
+
+// send the next frame of the cycle: only the bytes which are different from the frame the LCD
+// shows now (or which were drawn on since), in runs, all in one batch
+void LCD_grayscale::flip ()
+{
+  byte next = _frame + 1;
+  if (next >= LCD_GRAY_FRAMES)
+    next = 0;
+
+  unsigned long start = micros ();
+  unsigned int sent = 0;
+  byte now [128];
+  byte changed [16];   // bit per column
+
+  _lcd.beginBatch ();
+  for (byte page = 0; page < _pages; page++)
+    {
+    memset (changed, 0, sizeof changed);
+    for (byte x = 0; x < _width; x++)
+      {
+      now [x] = frameByte (next, x, page);
+      if (((_dirty [page] >> (x >> 3)) & 1) || now [x] != frameByte (_frame, x, page))
+        changed [x >> 3] |= 1 << (x & 7);
+      }
+
+    byte x = 0;
+    while (x < _width)
+      {
+      if (!((changed [x >> 3] >> (x & 7)) & 1))
+        {
+        x++;
+        continue;
+        }
+
+      // find the end of this run: stop when there are too many unchanged bytes in a row
+      byte last = x;
+      for (byte i = x + 1; i < _width && i - last <= LCD_DIFF_GAP + 1; i++)
+        if ((changed [i >> 3] >> (i & 7)) & 1)
+          last = i;
+
+      _lcd.gotoxy (_x + x, (_page + page) * 8);
+      sent += last + 1 - x;
+      for ( ; x <= last; x++)
+        _lcd.writeData (now [x]);
+      }  // end of while
+    }  // end of for each page
+  _lcd.endBatch ();
+
+  _frame = next;
+  memset (_dirty, 0, sizeof _dirty);
+
+  unsigned long taken = micros () - start;
+  _stats.frames++;
+  _stats.lastSend = taken;
+  _stats.sendMicros += taken;
+  if (taken > _stats.longestSend)
+    _stats.longestSend = taken;
+  _stats.lastBytes = sent;
+  _stats.bytes += sent;
+}  // end of LCD_grayscale::flip
+
+void LCD_grayscale::setPixel (const byte x,
+                              const byte y,
+                              const byte level)
+{
+  if (x >= _width || y >= height ())
+    return;
+
+  unsigned int i = (y >> 3) * _width + x;
+  byte bit = 1 << (y & 7);
+  byte * lo = &_planes [i];
+  byte * hi = &_planes [_pages * _width + i];
+
+  *lo = (level & 1) ? *lo | bit : *lo & ~bit;
+  *hi = (level & 2) ? *hi | bit : *hi & ~bit;
+  touch (y >> 3, x, x);
+}  // end of LCD_grayscale::setPixel
+
+byte LCD_grayscale::getPixel (const byte x,
+                              const byte y) const
+{
+  if (x >= _width || y >= height ())
+    return LCD_GRAY_WHITE;
+
+  unsigned int i = (y >> 3) * _width + x;
+  byte bit = 1 << (y & 7);
+  return ((_planes [i] & bit) ? 1 : 0) | ((_planes [_pages * _width + i] & bit) ? 2 : 0);
+}  // end of LCD_grayscale::getPixel
+
+// a byte at a time: only a partial top or bottom page needs a mask
+void LCD_grayscale::fillRect (const byte x1,
+                              const byte y1,
+                              byte x2,
+                              byte y2,
+                              const byte level)
+{
+  if (x2 >= _width)
+    x2 = _width - 1;
+  if (y2 >= height ())
+    y2 = height () - 1;
+  if (x1 > x2 || y1 > y2)
+    return;
+
+  for (byte page = y1 >> 3; page <= y2 >> 3; page++)
+    {
+    byte mask = 0xFF;
+    if (page == y1 >> 3)
+      mask &= 0xFF << (y1 & 7);
+    if (page == y2 >> 3)
+      mask &= 0xFF >> (7 - (y2 & 7));
+
+    byte * lo = &_planes [page * _width];
+    byte * hi = &_planes [(_pages + page) * _width];
+    byte loSet = (level & 1) ? mask : 0;
+    byte hiSet = (level & 2) ? mask : 0;
+    for (byte x = x1; x <= x2; x++)
+      {
+      lo [x] = (lo [x] & ~mask) | loSet;
+      hi [x] = (hi [x] & ~mask) | hiSet;
+      }
+    touch (page, x1, x2);
+    }  // end of for each page
+}  // end of LCD_grayscale::fillRect
+
+void LCD_grayscale::clear (const byte level)
+{
+  fillRect (0, 0, 255, 255, level);
+}  // end of LCD_grayscale::clear
@@ -0,0 +1,131 @@
+/*
+ LCD_grayscale.h
+
+ Four grey levels on I2C_graphical_LCD_display (which is black and white), by temporal dithering:
+ each pixel is black for 0, 1, 2 or 3 frames out of every 3, and the LCD (which is slow to change
+ anyway) averages that out.
+
+ Date: 19 October 2026.
+
+ The picture is held at 2 bits per pixel, in two planes laid out like the LCD (pages of column
+ bytes, LSB at the top). The three black-and-white frames are worked out from the planes a byte at a
+ time as they are sent. Pixels are staggered (diagonally) through the cycle, so a grey area has
+ the same number of black pixels in every frame - it shimmers slightly, rather than flashing.
+
+ Call service as often as you can (eg. every time round loop). When a frame is due it sends only the
+ bytes which differ between the frame the LCD shows and the next one, plus anything drawn since.
+ Frames are due at a fixed rate, measured from when the first one was due rather than from when the
+ last one was sent, so late frames don't push the later ones back. If service is called too late
+ for a frame, that frame is skipped (and counted), rather than hurrying to catch up.
+
+ stats shows whether the bus keeps up: if longestSend is close to the frame period (1000000 / rate
+ microseconds), or frames are being missed, try a faster I2C clock (see autotune), a lower rate,
+ or a smaller area.
+
+ Example:
+
+   I2C_graphical_LCD_display lcd;
+   byte planes [LCD_GRAY_SIZE (128, 4)];
+   LCD_grayscale gray (lcd, planes, 0, 4, 128, 4);   // the bottom half of the screen
+
+   void setup ()
+     {
+     lcd.begin ();
+     gray.begin (60);                                  // 60 frames a second (20 grey cycles)
+     gray.fillRect (0, 0, 63, 31, LCD_GRAY_LIGHT);
+     }
+
+   void loop ()
+     {
+     gray.service ();
+     ...                                               // draw with gray.setPixel, gray.fillRect
+     }
+
+ RAM used is the planes (2 bits per pixel: 2 KB for the whole screen, which is too much for a Uno -
+ use part of the screen) plus about 60 bytes.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_grayscale_H
+#define LCD_grayscale_H
+
+#include "I2C_graphical_LCD_display.h"
+
+// grey levels
+
+#define LCD_GRAY_WHITE   0
+#define LCD_GRAY_LIGHT   1   // black one frame in 3
+#define LCD_GRAY_DARK    2   // black two frames in 3
+#define LCD_GRAY_BLACK   3
+
+#define LCD_GRAY_FRAMES  3   // frames in one cycle
+
+// bytes needed for the planes of an area w pixels wide and "pages" pages (8 pixels) high
+#define LCD_GRAY_SIZE(w, pages) (2 * (w) * (pages))
+
+class LCD_grayscale
+{
+public:
+
+  struct Stats
+    {
+    unsigned long frames;         // frames sent
+    unsigned long missed;         // frames skipped because service was called too late for them
+    unsigned long longestLate;    // most a frame was sent after it was due (microseconds) - the jitter
+    unsigned long lastSend;       // time to send the last frame (microseconds)
+    unsigned long longestSend;    // longest time to send one frame
+    unsigned long sendMicros;     // total time spent sending
+    unsigned long bytes;          // total bytes sent
+    unsigned int lastBytes;       // bytes in the last frame
+    };
+
+  // constructor
+  LCD_grayscale (I2C_graphical_LCD_display & lcd,
+                 byte * planes,                   // LCD_GRAY_SIZE (width, pages) bytes
+                 const byte x = 0,                // left-hand column
+                 const byte page = 0,             // top page (0 to 7)
+                 const byte width = 128,          // columns
+                 const byte pages = 8);           // height in pages
+
+  void begin (const unsigned int rate = 60);   // clear to white, send it all next time, frames per second
+  void setRate (unsigned int rate);            // frames per second
+  boolean service ();                          // send the next frame, if it is due - true if it did
+
+  // drawing, in the area's coordinates (0,0 is its top left) - pixels outside it are ignored
+  void setPixel (const byte x, const byte y, const byte level);
+  byte getPixel (const byte x, const byte y) const;
+  void fillRect (const byte x1, const byte y1, byte x2, byte y2, const byte level);  // inclusive
+  void clear (const byte level = LCD_GRAY_WHITE);
+
+  byte width () const { return _width; }
+  byte height () const { return _pages * 8; }
+
+  const Stats & stats () const { return _stats; }
+  void resetStats ();
+
+private:
+
+  I2C_graphical_LCD_display & _lcd;
+
+  byte * _planes;   // low bits, then high bits: page * _width + x
+  byte _x;          // left-hand column on the LCD
+  byte _page;       // top page (0 to 7)
+  byte _width;      // columns in the area
+  byte _pages;      // height of the area in pages
+
+  byte _frame;                  // which frame of the cycle the LCD shows (0 to LCD_GRAY_FRAMES - 1)
+  unsigned int _dirty [8];      // per page: bit n = columns 8n to 8n + 7 drawn since they were sent
+  unsigned long _period;        // microseconds per frame
+  unsigned long _due;           // when the next frame is due (micros)
+
+  Stats _stats;
+
+  byte frameByte (const byte frame, const byte x, const byte page) const;
+  void touch (const byte page, const byte x1, const byte x2);
+  void flip ();
+
+};
+
+#endif  // LCD_grayscale_H
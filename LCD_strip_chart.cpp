@@ -0,0 +1,151 @@
+/*
+ LCD_strip_chart.cpp
+
+ Rolling chart of samples for I2C_graphical_LCD_display - see LCD_strip_chart.h
+
+ Date: 19 October 2026.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_strip_chart.h"
+
+// constructor
+LCD_strip_chart::LCD_strip_chart (I2C_graphical_LCD_display & lcd,
+                                  const byte x,
+                                  const byte width,
+                                  const byte page,
+                                  const byte pages,
+                                  const byte keep)
+  : _lcd (lcd), _x (x), _width (width), _page (page), _pages (pages), _keep (keep)
+{
+  // keep everything on the screen, and within our sample buffer
+  if (_x > 127)
+    _x = 127;
+  if (_width > LCD_CHART_MAX_WIDTH)
+    _width = LCD_CHART_MAX_WIDTH;
+  if (_width > 128 - _x)
+    _width = 128 - _x;
+  if (_width == 0)
+    _width = 1;
+  if (_page > 7)
+    _page = 7;
+  if (_pages > 8 - _page)
+    _pages = 8 - _page;
+  if (_pages == 0)
+    _pages = 1;
+  if (_keep >= _width)
+    _keep = _width - 1;
+
+  memset (_samples, LCD_CHART_NONE, sizeof _samples);
+  _column = 0;
+  _last = LCD_CHART_NONE;
+  _replaced = LCD_CHART_NONE;
+}  // end of LCD_strip_chart::LCD_strip_chart
+
+// work out one byte (page) of a column
+// the trace is a vertical line from the previous sample to this one, so it is continuous
+byte LCD_strip_chart::columnByte (const byte value,
+                                  const byte previous,
+                                  const byte page) const
+{
+  if (value == LCD_CHART_NONE)
+    return 0;   // empty column
+
+  byte lo = value, hi = value;
+  if (previous != LCD_CHART_NONE)
+    {
+    if (previous < lo)
+      lo = previous;
+    else
+      hi = previous;
+    }
+
+  // convert to pixel rows within this page (row 0 is the top of the chart)
+  int first = (height () - 1 - hi) - page * 8;
+  int last  = (height () - 1 - lo) - page * 8;
+
+  if (last < 0 || first > 7)
+    return 0;   // nothing in this page
+  if (first < 0)
+    first = 0;
+  if (last > 7)
+    last = 7;
+
+  return (0xFF << first) & (0xFF >> (7 - last));
+}  // end of LCD_strip_chart::columnByte
+
+// clear the chart area and forget all samples
+void LCD_strip_chart::begin ()
+{
+  memset (_samples, LCD_CHART_NONE, sizeof _samples);
+  _column = 0;
+  _last = LCD_CHART_NONE;
+  redraw ();
+}  // end of LCD_strip_chart::begin
+
+// add a sample: only the bytes of one column which change are sent to the LCD
+void LCD_strip_chart::add (byte value)
+{
+  if (value >= height ())
+    value = height () - 1;
+
+  // reached the right-hand side?
+  if (_column >= _width)
+    {
+    if (_keep)
+      {
+      // re-pack the most recent samples at the left, blank the rest
+      memmove (_samples, &_samples [_width - _keep], _keep);
+      memset (&_samples [_keep], LCD_CHART_NONE, _width - _keep);
+      _column = _keep;
+      redraw ();
+      }
+    else
+      _column = 0;   // sweep - just start writing at the left again
+    }
+
+  // This column was drawn from its old sample and the sample before it at the time.
+  // Columns are overwritten in the order they were drawn, so "the sample before it"
+  // is the one the previous add replaced.
+  byte old = _samples [_column];
+  byte oldPrevious = _replaced;
+
+  _replaced = old;
+  _samples [_column] = value;
+
+  _lcd.beginBatch ();
+  for (byte page = 0; page < _pages; page++)
+    {
+    byte was = columnByte (old, oldPrevious, page);
+    byte now = columnByte (value, _last, page);
+    if (was == now)
+      continue;   // unchanged - don't send it
+    _lcd.gotoxy (_x + _column, (_page + page) * 8);
+    _lcd.writeData (now);
+    }  // end of for each page
+  _lcd.endBatch ();
+
+  _last = value;
+  _column++;
+}  // end of LCD_strip_chart::add
+
+// draw the whole chart area, one batched page at a time
+void LCD_strip_chart::redraw ()
+{
+  _lcd.beginBatch ();
+  for (byte page = 0; page < _pages; page++)
+    {
+    _lcd.gotoxy (_x, (_page + page) * 8);
+    for (byte x = 0; x < _width; x++)
+      _lcd.writeData (columnByte (_samples [x], x ? _samples [x - 1] : LCD_CHART_NONE, page));
+    }  // end of for each page
+  _lcd.endBatch ();
+
+  // the next column to be overwritten was just drawn joined to the column before it
+  if (_column && _column < _width)
+    _replaced = _samples [_column - 1];
+  else
+    _replaced = LCD_CHART_NONE;
+}  // end of LCD_strip_chart::redraw
@@ -0,0 +1,77 @@
+/*
+ LCD_strip_chart.h
+
+ Rolling chart of samples (eg. a sensor reading) for I2C_graphical_LCD_display.
+
+ Date: 19 October 2026.
+
+ Each new sample only costs one column: the bytes of that column which actually
+ change (at most one per page) are sent, in a single batch. Rather than shifting
+ the existing pixels to make room, the chart "sweeps": the column we write to moves
+ right one place each sample, and wraps around to the left-hand side at the end.
+
+ Optionally, when the chart wraps, the most recent samples can be re-packed at the
+ left-hand side (so the chart reads left to right, oldest to newest, like a scrolling
+ chart). That is a full redraw of the chart area, so it only happens on wrap.
+
+ Example:
+
+   I2C_graphical_LCD_display lcd;
+   LCD_strip_chart chart (lcd, 0, 128, 2, 6);  // full width, pages 2 to 7 (48 pixels high)
+
+   lcd.begin ();
+   chart.begin ();
+   ...
+   chart.add (analogRead (0) / 22);  // 0 = bottom, 47 = top
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_strip_chart_H
+#define LCD_strip_chart_H
+
+#include "I2C_graphical_LCD_display.h"
+
+#define LCD_CHART_MAX_WIDTH 128   // RAM used for samples - reduce if your charts are narrower
+#define LCD_CHART_NONE      0xFF  // no sample in this column (yet)
+
+class LCD_strip_chart
+{
+private:
+
+  I2C_graphical_LCD_display & _lcd;
+
+  byte _x;          // left-hand column on the LCD
+  byte _width;      // columns in the chart
+  byte _page;       // top page (0 to 7)
+  byte _pages;      // height of chart in pages
+  byte _keep;       // samples re-packed at the left when the chart wraps (0 = sweep)
+
+  byte _column;     // column the next sample goes into
+  byte _last;       // most recent sample
+  byte _replaced;   // sample which the previous add overwrote
+
+  byte _samples [LCD_CHART_MAX_WIDTH];  // sample shown in each column
+
+  byte columnByte (const byte value, const byte previous, const byte page) const;
+
+public:
+
+  // constructor
+  LCD_strip_chart (I2C_graphical_LCD_display & lcd,
+                   const byte x = 0,        // left-hand column
+                   const byte width = 128,  // columns
+                   const byte page = 0,     // top page (0 to 7)
+                   const byte pages = 8,    // height in pages (1 to 8)
+                   const byte keep = 0);    // samples to re-pack on wrap (0 = sweep, no re-pack)
+
+  void begin ();                // clear the chart area and forget all samples
+  void add (byte value);        // add a sample (0 = bottom of chart), clipped to fit
+  void redraw ();               // draw the whole chart again
+
+  byte height () const { return _pages * 8; }   // in pixels
+
+};
+
+#endif  // LCD_strip_chart_H
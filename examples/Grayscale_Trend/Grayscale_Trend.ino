@@ -0,0 +1,72 @@
+
+// Demo of grey levels (temporal dithering) on a KS0108B graphics LCD screen connected to MCP23017 16-port I/O expander
+
+// A trend of analog pin A0 in black, over light and dark grey bands, in the bottom half of the screen.
+// Once a second the frame statistics go to the serial monitor, to show whether the bus keeps up.
+
+
+#include <Wire.h>
+#include <SPI.h>
+#include <I2C_graphical_LCD_display.h>
+#include <LCD_grayscale.h>
+
+I2C_graphical_LCD_display lcd;
+
+// full width, pages 4 to 7 (32 pixels high): 1 KB of planes
+byte planes [LCD_GRAY_SIZE (128, 4)];
+LCD_grayscale gray (lcd, planes, 0, 4, 128, 4);
+
+byte column;
+unsigned long lastSample;
+unsigned long lastReport;
+
+// the background of one column: dark grey above 24, light grey above 16
+void background (const byte x)
+{
+  gray.fillRect (x, 0, x, 7, LCD_GRAY_DARK);
+  gray.fillRect (x, 8, x, 15, LCD_GRAY_LIGHT);
+  gray.fillRect (x, 16, x, 31, LCD_GRAY_WHITE);
+}  // end of background
+
+void setup () 
+{
+  Serial.begin (115200);
+  lcd.begin ();  
+  lcd.gotoxy (0, 0);
+  lcd.string ("Analog input A0");
+  gray.begin (60);
+  for (byte x = 0; x < gray.width (); x++)
+    background (x);
+}  // end of setup
+
+void loop () 
+{
+  gray.service ();
+  
+  if (millis () - lastSample >= 50)
+    {
+    lastSample = millis ();
+    // scale 0 to 1023 into 0 to 31 (0 at the bottom)
+    byte value = analogRead (0) / 32;
+    background (column);
+    gray.setPixel (column, 31 - value, LCD_GRAY_BLACK);
+    if (++column >= gray.width ())
+      column = 0;
+    }
+  
+  if (millis () - lastReport >= 1000)
+    {
+    lastReport = millis ();
+    const LCD_grayscale::Stats & stats = gray.stats ();
+    Serial.print (F ("frames: "));
+    Serial.print (stats.frames);
+    Serial.print (F (", missed: "));
+    Serial.print (stats.missed);
+    Serial.print (F (", longest send: "));
+    Serial.print (stats.longestSend);
+    Serial.print (F (" us, jitter: "));
+    Serial.print (stats.longestLate);
+    Serial.println (F (" us"));
+    gray.resetStats ();
+    }
+}  // end of loop
@@ -0,0 +1,67 @@
+// Converting a row-by-row (1 bit per pixel) image to the LCD's column bytes:
+// importRows (8 x 8 bit transpose) compared to testing one pixel at a time.
+
+// Results are printed to the serial monitor at 115200 baud, then the image is drawn.
+
+
+#include <Wire.h>
+#include <SPI.h>
+#include <I2C_graphical_LCD_display.h>
+
+I2C_graphical_LCD_display lcd;
+
+#define WIDTH  128
+#define HEIGHT 64
+#define STRIDE (WIDTH / 8)
+#define REPEATS 20
+
+byte image [HEIGHT * STRIDE];   // row by row, leftmost pixel in the high bit
+byte page [WIDTH];
+
+// the obvious way: every pixel tested and set separately
+void naiveRows (const byte * rows, const byte w, byte * out)
+{
+  for (byte x = 0; x < w; x++)
+    {
+    byte b = 0;
+    for (byte r = 0; r < 8; r++)
+      if (rows [r * STRIDE + x / 8] & (0x80 >> (x % 8)))
+        b |= 1 << r;
+    out [x] = b;
+    }
+}  // end of naiveRows
+
+void setup () 
+{
+  Serial.begin (115200);
+  
+  // something to look at: a checkerboard of diagonal lines
+  for (int y = 0; y < HEIGHT; y++)
+    for (int i = 0; i < STRIDE; i++)
+      image [y * STRIDE + i] = ((y / 8 + i) & 1) ? (0x80 >> (y & 7)) : (0x01 << (y & 7));
+  
+  unsigned long start = micros ();
+  for (byte n = 0; n < REPEATS; n++)
+    for (byte p = 0; p < HEIGHT / 8; p++)
+      naiveRows (&image [p * 8 * STRIDE], WIDTH, page);
+  unsigned long naive = (micros () - start) / REPEATS;
+  
+  start = micros ();
+  for (byte n = 0; n < REPEATS; n++)
+    for (byte p = 0; p < HEIGHT / 8; p++)
+      I2C_graphical_LCD_display::importRows (&image [p * 8 * STRIDE], STRIDE, WIDTH, page);
+  unsigned long fast = (micros () - start) / REPEATS;
+  
+  Serial.print (F("Per screen - one pixel at a time: "));
+  Serial.print (naive);
+  Serial.print (F(" us, importRows: "));
+  Serial.print (fast);
+  Serial.println (F(" us"));
+  
+  lcd.begin ();
+  lcd.blitRows (0, 0, image, STRIDE, WIDTH, HEIGHT);
+}  // end of setup
+
+void loop () 
+{
+}  // end of loop
@@ -0,0 +1,35 @@
+
+// Demo of a rolling strip chart on a KS0108B graphics LCD screen connected to MCP23017 16-port I/O expander
+
+// Samples analog pin A0 twenty times a second.
+
+
+#include <Wire.h>
+#include <SPI.h>
+#include <I2C_graphical_LCD_display.h>
+#include <LCD_strip_chart.h>
+
+I2C_graphical_LCD_display lcd;
+
+// full width, pages 2 to 7 (48 pixels high)
+LCD_strip_chart chart (lcd, 0, 128, 2, 6);
+
+unsigned long lastSample;
+
+void setup () 
+{
+  lcd.begin ();  
+  lcd.gotoxy (0, 0);
+  lcd.string ("Analog input A0");
+  chart.begin ();
+}  // end of setup
+
+void loop () 
+{
+  if (millis () - lastSample < 50)
+    return;
+  lastSample = millis ();
+  
+  // scale 0 to 1023 into 0 to 47
+  chart.add (analogRead (0) * (unsigned long) chart.height () / 1024);
+}  // end of loop
@@ -0,0 +1,397 @@
+/*
+ LCD_emulator.cpp
+
+ In-process emulator of the MCP23017 / KS0108 combination - see LCD_emulator.h
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_emulator.h"
+
+#include <stdio.h>
+
+// MCP23017 register numbers (BANK = 0), as in I2C_graphical_LCD_display.h
+
+#define EMU_IODIRA  0x00
+#define EMU_IODIRB  0x01
+#define EMU_IOPOLA  0x02
+#define EMU_IOPOLB  0x03
+#define EMU_IOCON   0x0A
+#define EMU_IOCON2  0x0B
+#define EMU_GPIOA   0x12
+#define EMU_GPIOB   0x13
+#define EMU_OLATA   0x14
+#define EMU_OLATB   0x15
+
+#define EMU_IOCON_SEQOP 0x20   // 1 = byte mode (address pointer toggles between A and B)
+
+// control lines on port A
+
+#define EMU_CS1    0x04
+#define EMU_CS2    0x08
+#define EMU_RESET  0x10
+#define EMU_DATA   0x20
+#define EMU_READ   0x40
+#define EMU_ENABLE 0x80
+
+LCD_emulator::LCD_emulator (const byte port) : _port (port), _maxTransaction (32), _clock (100000)
+{
+  memset (_chip, 0, sizeof _chip);
+  powerOn ();
+  resetStats ();
+}  // end of LCD_emulator::LCD_emulator
+
+void LCD_emulator::powerOn ()
+{
+  memset (_reg, 0, sizeof _reg);
+  _reg [EMU_IODIRA] = 0xFF;   // all inputs after power-on
+  _reg [EMU_IODIRB] = 0xFF;
+  _pointer = 0;
+  _inTransaction = false;
+  _expectRegister = false;
+  _transactionBytes = 0;
+  _portA = 0;
+  reset ();
+}  // end of LCD_emulator::powerOn
+
+void LCD_emulator::resetStats ()
+{
+  memset (&_stats, 0, sizeof _stats);
+}  // end of LCD_emulator::resetStats
+
+// each transaction is: start, address + ack, (data + ack) * n, stop
+unsigned long LCD_emulator::busMicros () const
+{
+  return (unsigned long) ((unsigned long long) _stats.bits * 1000000ULL / _clock);
+}  // end of LCD_emulator::busMicros
+
+// KS0108 reset: display off, start line zero (RAM is not cleared)
+void LCD_emulator::reset ()
+{
+  for (byte i = 0; i < 2; i++)
+    {
+    _chip [i].on = false;
+    _chip [i].startLine = 0;
+    }
+}  // end of LCD_emulator::reset
+
+void LCD_emulator::startSend (const byte port)
+{
+  _inTransaction = port == _port;
+  _expectRegister = true;
+  _transactionBytes = 0;
+  _stats.transactions++;
+  _stats.bits += 2 + 9;   // start, stop, address byte
+}  // end of LCD_emulator::startSend
+
+void LCD_emulator::doSend (const byte what)
+{
+  _stats.bytes++;
+  _stats.bits += 9;
+  _transactionBytes++;
+
+  if (!_inTransaction)
+    return;
+
+  if (_expectRegister)
+    {
+    _pointer = what % sizeof _reg;
+    _expectRegister = false;
+    return;
+    }
+
+  writeReg (_pointer, what);
+  advancePointer ();
+}  // end of LCD_emulator::doSend
+
+byte LCD_emulator::endSend ()
+{
+  boolean ok = _inTransaction && _transactionBytes <= _maxTransaction;
+  _inTransaction = false;
+  if (!ok)
+    return _transactionBytes > _maxTransaction ? 1 : 2;   // as Wire: 1 = too long, 2 = address NAK
+  return 0;
+}  // end of LCD_emulator::endSend
+
+byte LCD_emulator::requestByte (const byte port)
+{
+  _stats.reads++;
+  _stats.bits += 2 + 9 + 9;   // start, stop, address byte, one data byte
+
+  if (port != _port)
+    return 0;
+
+  byte data = readReg (_pointer);
+  advancePointer ();
+  return data;
+}  // end of LCD_emulator::requestByte
+
+// in byte mode the pointer toggles between the A/B pair, otherwise it increments
+void LCD_emulator::advancePointer ()
+{
+  if (_reg [EMU_IOCON] & EMU_IOCON_SEQOP)
+    _pointer ^= 1;
+  else
+    _pointer = (_pointer + 1) % sizeof _reg;
+}  // end of LCD_emulator::advancePointer
+
+void LCD_emulator::writeReg (byte which, const byte data)
+{
+  switch (which)
+    {
+    case EMU_IOCON:
+    case EMU_IOCON2:
+      _reg [EMU_IOCON] = _reg [EMU_IOCON2] = data;
+      break;
+
+    case EMU_GPIOA:
+    case EMU_OLATA:
+      {
+      _reg [EMU_OLATA] = data;
+      byte oldA = _portA;
+      _portA = data & ~_reg [EMU_IODIRA];
+      portAChanged (oldA, _portA);
+      }
+      break;
+
+    case EMU_GPIOB:
+    case EMU_OLATB:
+      _reg [EMU_OLATB] = data;
+      break;
+
+    case EMU_IODIRA:
+      {
+      _reg [which] = data;
+      byte oldA = _portA;
+      _portA = _reg [EMU_OLATA] & ~data;
+      portAChanged (oldA, _portA);
+      }
+      break;
+
+    default:
+      _reg [which] = data;
+      break;
+    }  // end of switch
+}  // end of LCD_emulator::writeReg
+
+byte LCD_emulator::readReg (byte which) const
+{
+  switch (which)
+    {
+    case EMU_IOCON2:
+      return _reg [EMU_IOCON];
+
+    case EMU_GPIOA:
+      return _portA ^ _reg [EMU_IOPOLA];
+
+    case EMU_GPIOB:
+      {
+      // output pins read back the latch, input pins read whatever the display drives
+      byte pins = (_reg [EMU_OLATB] & ~_reg [EMU_IODIRB]) |
+                  (busFromDisplay () & _reg [EMU_IODIRB]);
+      return pins ^ _reg [EMU_IOPOLB];
+      }
+
+    default:
+      return _reg [which];
+    }  // end of switch
+}  // end of LCD_emulator::readReg
+
+// what the KS0108 puts on the data lines (only while E is high during a read)
+byte LCD_emulator::busFromDisplay () const
+{
+  if ((_portA & (EMU_ENABLE | EMU_READ)) != (EMU_ENABLE | EMU_READ))
+    return 0;
+
+  byte data = 0xFF;   // selecting both chips at once: open-drain-like AND
+  boolean driven = false;
+  for (byte i = 0; i < 2; i++)
+    {
+    if (!(_portA & (i ? EMU_CS2 : EMU_CS1)))
+      continue;
+    byte value;
+    if (_portA & EMU_DATA)
+      value = _chip [i].output;
+    else
+      value = (_chip [i].on ? 0 : 0x20) | ((_portA & EMU_RESET) ? 0 : 0x10);   // status
+    data &= value;
+    driven = true;
+    }
+
+  return driven ? data : 0;
+}  // end of LCD_emulator::busFromDisplay
+
+void LCD_emulator::portAChanged (const byte oldA, const byte newA)
+{
+  if (!(newA & EMU_RESET))
+    {
+    reset ();
+    return;
+    }
+
+  // rising E: a status or data read puts data on the bus (nothing to do until it is read)
+  if ((newA & EMU_ENABLE) && !(oldA & EMU_ENABLE) && (newA & EMU_READ) && (newA & (EMU_CS1 | EMU_CS2)))
+    {
+    if (newA & EMU_DATA)
+      _stats.dataReads++;
+    else
+      _stats.statusReads++;
+    }
+
+  // everything else happens on the falling edge of E
+  if (!((oldA & EMU_ENABLE) && !(newA & EMU_ENABLE)))
+    return;
+
+  // control lines are sampled as they were while E was high
+  byte control = oldA;
+  byte bus = _reg [EMU_OLATB] & ~_reg [EMU_IODIRB];   // data lines driven by the expander
+
+  if (!(control & EMU_READ) && (control & (EMU_CS1 | EMU_CS2)))
+    {
+    if (control & EMU_DATA)
+      _stats.dataWrites++;
+    else
+      _stats.commands++;
+    }
+
+  for (byte i = 0; i < 2; i++)
+    {
+    if (!(control & (i ? EMU_CS2 : EMU_CS1)))
+      continue;
+
+    Chip & chip = _chip [i];
+
+    if (control & EMU_READ)
+      {
+      // after a data read the next byte is fetched into the output register
+      if (control & EMU_DATA)
+        {
+        chip.output = chip.ram [chip.page] [chip.addr];
+        chip.addr = (chip.addr + 1) & 63;
+        }
+      continue;
+      }
+
+    if (control & EMU_DATA)
+      {
+      chip.ram [chip.page] [chip.addr] = bus;
+      chip.addr = (chip.addr + 1) & 63;
+      continue;
+      }
+
+    // instructions
+    if ((bus & 0xFE) == 0x3E)
+      chip.on = bus & 1;
+    else if ((bus & 0xC0) == 0x40)
+      chip.addr = bus & 63;
+    else if ((bus & 0xF8) == 0xB8)
+      chip.page = bus & 7;
+    else if ((bus & 0xC0) == 0xC0)
+      chip.startLine = bus & 63;
+    }  // end of for each chip
+
+}  // end of LCD_emulator::portAChanged
+
+// 1 if the pixel at x,y is black (display off counts as all white)
+byte LCD_emulator::pixel (const byte x, const byte y) const
+{
+  const Chip & chip = _chip [(x >> 6) & 1];
+  if (!chip.on)
+    return 0;
+  byte row = (y + chip.startLine) & 63;
+  return (chip.ram [row >> 3] [x & 63] >> (row & 7)) & 1;
+}  // end of LCD_emulator::pixel
+
+void LCD_emulator::frame (byte * frame) const
+{
+  memset (frame, 0, LCD_EMULATOR_FRAME_SIZE);
+  for (byte y = 0; y < 64; y++)
+    for (byte x = 0; x < 128; x++)
+      if (pixel (x, y))
+        frame [(y >> 3) * 128 + x] |= 1 << (y & 7);
+}  // end of LCD_emulator::frame
+
+unsigned int LCD_emulator::compare (const byte * golden) const
+{
+  byte current [LCD_EMULATOR_FRAME_SIZE];
+  frame (current);
+
+  unsigned int differences = 0;
+  for (unsigned int i = 0; i < LCD_EMULATOR_FRAME_SIZE; i++)
+    if (current [i] != golden [i])
+      differences++;
+  return differences;
+}  // end of LCD_emulator::compare
+
+// binary (P4) PBM: 1 = black, rows packed MSB first
+boolean LCD_emulator::savePBM (const char * filename) const
+{
+  FILE * f = fopen (filename, "wb");
+  if (!f)
+    return false;
+
+  fprintf (f, "P4\n128 64\n");
+  for (byte y = 0; y < 64; y++)
+    for (byte x = 0; x < 128; x += 8)
+      {
+      byte b = 0;
+      for (byte i = 0; i < 8; i++)
+        b = (b << 1) | pixel (x + i, y);
+      fputc (b, f);
+      }
+
+  return fclose (f) == 0;
+}  // end of LCD_emulator::savePBM
+
+// reads a 128 x 64 P4 or P1 PBM into frame layout
+boolean LCD_emulator::loadPBM (const char * filename, byte * frame) const
+{
+  FILE * f = fopen (filename, "rb");
+  if (!f)
+    return false;
+
+  char magic [3] = { 0 };
+  int width, height;
+  if (fscanf (f, "%2s %d %d", magic, &width, &height) != 3 ||
+      width != 128 || height != 64 ||
+      (strcmp (magic, "P4") != 0 && strcmp (magic, "P1") != 0))
+    {
+    fclose (f);
+    return false;
+    }
+
+  boolean binary = magic [1] == '4';
+  if (binary)
+    fgetc (f);   // single whitespace character after the header
+
+  memset (frame, 0, LCD_EMULATOR_FRAME_SIZE);
+  boolean ok = true;
+  int b = 0;
+  for (byte y = 0; y < 64 && ok; y++)
+    for (byte x = 0; x < 128 && ok; x++)
+      {
+      int bit;
+      if (binary)
+        {
+        if ((x & 7) == 0)
+          b = fgetc (f);
+        ok = b != EOF;
+        bit = (b >> (7 - (x & 7))) & 1;
+        }
+      else
+        {
+        int c;
+        do
+          c = fgetc (f);
+        while (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+        ok = c == '0' || c == '1';
+        bit = c == '1';
+        }
+      if (bit)
+        frame [(y >> 3) * 128 + x] |= 1 << (y & 7);
+      }
+
+  fclose (f);
+  return ok;
+}  // end of LCD_emulator::loadPBM
@@ -0,0 +1,130 @@
+/*
+ LCD_emulator.h
+
+ In-process emulator of the MCP23017 I/O expander driving a KS0108 display
+ (two controller chips, each 64 x 64 pixels), for running the library on a Linux host.
+
+ The emulator decodes the bytes sent by the display driver exactly as the hardware would:
+   * the MCP23017 register file (IODIR, GPIO/OLAT, IOPOL, IOCON byte or sequential mode)
+   * E / R/W / D/I / CS1 / CS2 / RST edges on port A
+   * the KS0108 page and address registers, auto-increment, display on/off,
+     display start line, status reads and the dummy read
+
+ It also counts transactions, bytes and E strobes, and works out how long they would
+ have taken on a real I2C bus, so drawing functions can be checked pixel-exactly against
+ golden images and their bus cost compared from one version to the next.
+
+ Example:
+
+   LCD_emulator emu;
+   I2C_graphical_LCD_display lcd;
+   lcd.setTransport (emu);
+   lcd.begin ();
+   lcd.string ("Hello");
+   emu.savePBM ("hello.pbm");
+   printf ("%lu us\n", emu.busMicros ());
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_emulator_H
+#define LCD_emulator_H
+
+#include "LCD_host.h"
+
+#define LCD_EMULATOR_FRAME_SIZE (128 * 64 / 8)   // bytes in a frame (page-major, 128 bytes per page)
+
+class LCD_emulator : public LCD_transport
+{
+public:
+
+  // bus traffic counters
+  struct Stats
+    {
+    unsigned long transactions;   // write transactions (start ... stop)
+    unsigned long reads;          // single-byte read transactions
+    unsigned long bytes;          // bytes written, including register bytes
+    unsigned long bits;           // I2C bit times, including start, address, ack and stop
+    unsigned long commands;       // instructions latched by a KS0108
+    unsigned long dataWrites;     // data bytes latched by a KS0108
+    unsigned long dataReads;      // data reads (including dummy reads) from a KS0108
+    unsigned long statusReads;    // status reads from a KS0108
+    };
+
+  LCD_emulator (const byte port = 0x20);
+
+  // LCD_transport
+  virtual void startSend (const byte port);
+  virtual void doSend (const byte what);
+  virtual byte endSend ();
+  virtual byte requestByte (const byte port);
+  virtual void setClock (const unsigned long hz) { _clock = hz; }
+  virtual unsigned int maxTransaction () { return _maxTransaction; }
+
+  // power cycle both the expander and the display (RAM contents are kept, as on real glass)
+  void powerOn ();
+
+  // Wire on an Uno can only send 32 bytes at a time; change this to model other hosts
+  void setMaxTransaction (const unsigned int bytes) { _maxTransaction = bytes; }
+
+  // statistics
+  const Stats & stats () const { return _stats; }
+  void resetStats ();
+  unsigned long busMicros () const;   // time the traffic would take at the current clock
+
+  // what the display is showing (taking the display start line into account)
+  byte pixel (const byte x, const byte y) const;
+  boolean displayOn (const byte chip) const { return _chip [chip].on; }
+  byte startLine (const byte chip) const { return _chip [chip].startLine; }
+
+  // raw controller RAM
+  byte ram (const byte chip, const byte page, const byte addr) const
+    { return _chip [chip & 1].ram [page & 7] [addr & 63]; }
+  void setRam (const byte chip, const byte page, const byte addr, const byte data)
+    { _chip [chip & 1].ram [page & 7] [addr & 63] = data; }
+
+  // golden-image support: frames are LCD_EMULATOR_FRAME_SIZE bytes, page-major,
+  // 128 bytes per page, LSB at the top - the same layout as a frame given to lcd.display
+  void frame (byte * frame) const;
+  unsigned int compare (const byte * golden) const;   // number of bytes which differ
+  boolean savePBM (const char * filename) const;
+  boolean loadPBM (const char * filename, byte * frame) const;
+
+  // MCP23017 register (BANK = 0 numbering)
+  byte reg (const byte which) const { return _reg [which % sizeof _reg]; }
+
+private:
+
+  struct Chip
+    {
+    byte ram [8] [64];
+    byte page;
+    byte addr;
+    byte startLine;
+    byte output;      // output register (what a data read returns)
+    boolean on;
+    };
+
+  void writeReg (byte which, const byte data);
+  byte readReg (byte which) const;
+  void advancePointer ();
+  void portAChanged (const byte oldA, const byte newA);
+  byte busFromDisplay () const;
+  void reset ();
+
+  byte _port;
+  byte _reg [0x16];
+  byte _pointer;
+  boolean _inTransaction;
+  boolean _expectRegister;
+  unsigned int _transactionBytes;
+  unsigned int _maxTransaction;
+  byte _portA;      // levels on the control lines
+  Chip _chip [2];
+  unsigned long _clock;
+  Stats _stats;
+
+};  // end of class LCD_emulator
+
+#endif  // LCD_emulator_H
@@ -0,0 +1,230 @@
+/*
+ LCD_host.h
+
+ Minimal stand-ins for the parts of the Arduino core used by I2C_graphical_LCD_display,
+ so that the library can be compiled and run on a Linux host.
+
+ On the host there is no Wire or SPI library. Instead the display talks to an
+ LCD_transport object (see below) - for example the LCD_emulator in this directory,
+ or LCD_i2c_dev which talks to a real MCP23017 through /dev/i2c-N.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_host_H
+#define LCD_host_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT  0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// there is only one address space on the host, so PROGMEM is ordinary memory
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr)  (*(const uint8_t *) (addr))
+#define pgm_read_word(addr)  (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *> (s))
+
+inline unsigned long micros ()
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (unsigned long) ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}  // end of micros
+
+inline unsigned long millis ()
+{
+  return micros () / 1000;
+}  // end of millis
+
+inline void delayMicroseconds (const unsigned int us)
+{
+  struct timespec ts;
+  ts.tv_sec = us / 1000000;
+  ts.tv_nsec = (long) (us % 1000000) * 1000;
+  nanosleep (&ts, NULL);
+}  // end of delayMicroseconds
+
+inline void delay (const unsigned long ms)
+{
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (long) (ms % 1000) * 1000000;
+  nanosleep (&ts, NULL);
+}  // end of delay
+
+inline void pinMode (const byte pin, const byte mode) {}
+inline void digitalWrite (const byte pin, const byte val) {}
+
+// cut-down version of the Arduino Print class
+
+class Print
+{
+private:
+  size_t printNumber (unsigned long n, byte base)
+  {
+    char buf [8 * sizeof (long) + 1];
+    char * str = &buf [sizeof (buf) - 1];
+
+    *str = 0;
+    if (base < 2)
+      base = 10;
+
+    do
+      {
+      char c = n % base;
+      n /= base;
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+      } while (n);
+
+    return write (str);
+  }  // end of Print::printNumber
+
+  size_t printFloat (double number, byte digits)
+  {
+    size_t n = 0;
+
+    if (isnan (number))
+      return print ("nan");
+    if (isinf (number))
+      return print ("inf");
+
+    if (number < 0.0)
+      {
+      n += print ('-');
+      number = -number;
+      }
+
+    // round correctly so that print(1.999, 2) prints as "2.00"
+    double rounding = 0.5;
+    for (byte i = 0; i < digits; i++)
+      rounding /= 10.0;
+    number += rounding;
+
+    unsigned long int_part = (unsigned long) number;
+    double remainder = number - (double) int_part;
+    n += print (int_part);
+
+    if (digits > 0)
+      n += print ('.');
+
+    while (digits-- > 0)
+      {
+      remainder *= 10.0;
+      unsigned int toPrint = (unsigned int) remainder;
+      n += print (toPrint);
+      remainder -= toPrint;
+      }
+
+    return n;
+  }  // end of Print::printFloat
+
+public:
+  virtual ~Print () {}
+
+  virtual size_t write (uint8_t) = 0;
+  virtual size_t write (const uint8_t * buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--)
+      n += write (*buffer++);
+    return n;
+  }  // end of Print::write
+
+  size_t write (const char * str)
+  {
+    if (str == NULL)
+      return 0;
+    return write ((const uint8_t *) str, strlen (str));
+  }  // end of Print::write
+
+  size_t write (const char * buffer, size_t size) { return write ((const uint8_t *) buffer, size); }
+
+  size_t print (const __FlashStringHelper * s) { return write ((const char *) s); }
+  size_t print (const char str []) { return write (str); }
+  size_t print (char c) { return write ((uint8_t) c); }
+  size_t print (unsigned char n, int base = DEC) { return print ((unsigned long) n, base); }
+  size_t print (int n, int base = DEC) { return print ((long) n, base); }
+  size_t print (unsigned int n, int base = DEC) { return print ((unsigned long) n, base); }
+  size_t print (long n, int base = DEC)
+  {
+    if (base == 0)
+      return write ((uint8_t) n);
+    if (base == 10 && n < 0)
+      return print ('-') + printNumber (- (unsigned long) n, 10);
+    return printNumber (n, base);
+  }  // end of Print::print
+  size_t print (unsigned long n, int base = DEC)
+  {
+    if (base == 0)
+      return write ((uint8_t) n);
+    return printNumber (n, base);
+  }  // end of Print::print
+  size_t print (double n, int digits = 2) { return printFloat (n, digits); }
+
+  size_t println () { return write ("\r\n"); }
+  size_t println (const __FlashStringHelper * s) { return print (s) + println (); }
+  size_t println (const char c []) { return print (c) + println (); }
+  size_t println (char c) { return print (c) + println (); }
+  size_t println (unsigned char n, int base = DEC) { return print (n, base) + println (); }
+  size_t println (int n, int base = DEC) { return print (n, base) + println (); }
+  size_t println (unsigned int n, int base = DEC) { return print (n, base) + println (); }
+  size_t println (long n, int base = DEC) { return print (n, base) + println (); }
+  size_t println (unsigned long n, int base = DEC) { return print (n, base) + println (); }
+  size_t println (double n, int digits = 2) { return print (n, digits) + println (); }
+
+};  // end of class Print
+
+// The host equivalent of Wire (or SPI): something that can carry bytes to and from
+// the MCP23017. The calls mirror I2C semantics, as used by the display:
+//    startSend / doSend / endSend  - one write transaction (first byte is the register)
+//    requestByte                   - read one byte from the current register
+// endSend (and flush) return 0 on success, otherwise an error code, like Wire.endTransmission.
+
+class LCD_transport
+{
+public:
+  virtual ~LCD_transport () {}
+
+  virtual void startSend (const byte port) = 0;
+  virtual void doSend (const byte what) = 0;
+  virtual byte endSend () = 0;
+  virtual byte requestByte (const byte port) = 0;
+
+  // send anything held back (for transports which queue up their writes)
+  // the display calls this at the end of each batch, and after each write made outside a batch
+  virtual byte flush () { return 0; }
+
+  // bus clock in Hz (for transports where it means something)
+  virtual void setClock (const unsigned long hz) {}
+
+  // most bytes (including the register byte) allowed in one transaction
+  virtual unsigned int maxTransaction () { return 32; }
+
+};  // end of class LCD_transport
+
+#endif  // LCD_host_H
@@ -0,0 +1,164 @@
+/*
+ LCD_i2c_dev.cpp
+
+ Linux /dev/i2c-N transport for I2C_graphical_LCD_display - see LCD_i2c_dev.h
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_i2c_dev.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+// error codes, as returned by Wire.endTransmission
+#define I2C_DEV_TOO_LONG  1
+#define I2C_DEV_OTHER     4
+
+LCD_i2c_dev::LCD_i2c_dev () : _fd (-1), _count (0), _used (0), _maxTransaction (256),
+                              _building (false), _error (0)
+{
+  resetStats ();
+}  // end of LCD_i2c_dev::LCD_i2c_dev
+
+LCD_i2c_dev::~LCD_i2c_dev ()
+{
+  close ();
+}  // end of LCD_i2c_dev::~LCD_i2c_dev
+
+boolean LCD_i2c_dev::open (const char * device)
+{
+  close ();
+  _fd = ::open (device, O_RDWR);
+  return _fd >= 0;
+}  // end of LCD_i2c_dev::open
+
+void LCD_i2c_dev::close ()
+{
+  if (_fd < 0)
+    return;
+  send ();
+  ::close (_fd);
+  _fd = -1;
+}  // end of LCD_i2c_dev::close
+
+void LCD_i2c_dev::resetStats ()
+{
+  memset (&_stats, 0, sizeof _stats);
+}  // end of LCD_i2c_dev::resetStats
+
+double LCD_i2c_dev::syscallsPerFrame () const
+{
+  if (_stats.frames == 0)
+    return 0;
+  return (double) _stats.syscalls / _stats.frames;
+}  // end of LCD_i2c_dev::syscallsPerFrame
+
+void LCD_i2c_dev::setMaxTransaction (const unsigned int bytes)
+{
+  _maxTransaction = bytes;
+  if (_maxTransaction > LCD_I2C_DEV_BUFFER)
+    _maxTransaction = LCD_I2C_DEV_BUFFER;
+  if (_maxTransaction < 2)
+    _maxTransaction = 2;
+}  // end of LCD_i2c_dev::setMaxTransaction
+
+// start a new write message (sending what we have first, if there might not be room for it)
+void LCD_i2c_dev::startSend (const byte port)
+{
+  if (_count >= LCD_I2C_DEV_MAX_MSGS || _used + _maxTransaction > LCD_I2C_DEV_BUFFER)
+    send ();
+
+  struct i2c_msg & msg = _msgs [_count++];
+  msg.addr = port;
+  msg.flags = 0;
+  msg.len = 0;
+  msg.buf = &_buffer [_used];
+  _building = true;
+}  // end of LCD_i2c_dev::startSend
+
+void LCD_i2c_dev::doSend (const byte what)
+{
+  if (!_building)
+    return;
+
+  struct i2c_msg & msg = _msgs [_count - 1];
+  if (msg.len >= _maxTransaction)
+    {
+    _error = I2C_DEV_TOO_LONG;   // as Wire does, the extra bytes are lost
+    return;
+    }
+
+  _buffer [_used++] = what;
+  msg.len++;
+  _stats.bytes++;
+}  // end of LCD_i2c_dev::doSend
+
+// the message is only queued, so the result is from the last messages actually sent
+byte LCD_i2c_dev::endSend ()
+{
+  _building = false;
+  byte error = _error;
+  _error = 0;
+  return error;
+}  // end of LCD_i2c_dev::endSend
+
+// add a one-byte read to the queued writes and send the lot
+byte LCD_i2c_dev::requestByte (const byte port)
+{
+  if (_count >= LCD_I2C_DEV_MAX_MSGS)
+    send ();
+
+  struct i2c_msg & msg = _msgs [_count++];
+  msg.addr = port;
+  msg.flags = I2C_M_RD;
+  msg.len = 1;
+  msg.buf = &_read;
+
+  _read = 0;   // as Wire, 0 if the read fails (and the error is reported at the next endSend or flush)
+  send ();
+  _stats.reads++;
+  return _read;
+}  // end of LCD_i2c_dev::requestByte
+
+// send the queued messages - returns any error since the last endSend or flush
+byte LCD_i2c_dev::flush ()
+{
+  if (_building)
+    return 0;
+
+  send ();
+  byte error = _error;
+  _error = 0;
+  return error;
+}  // end of LCD_i2c_dev::flush
+
+// the error stays until the display asks for it, so one in a send we make ourselves isn't lost
+void LCD_i2c_dev::send ()
+{
+  if (_count == 0)
+    return;
+
+  _stats.syscalls++;
+  _stats.messages += _count;
+  if (transfer (_msgs, _count) < 0)
+    {
+    _error = I2C_DEV_OTHER;
+    _stats.errors++;
+    }
+
+  _count = 0;
+  _used = 0;
+}  // end of LCD_i2c_dev::send
+
+int LCD_i2c_dev::transfer (struct i2c_msg * msgs,
+                           const unsigned int count)
+{
+  struct i2c_rdwr_ioctl_data data;
+  data.msgs = msgs;
+  data.nmsgs = count;
+  return ioctl (_fd, I2C_RDWR, &data);
+}  // end of LCD_i2c_dev::transfer
@@ -0,0 +1,107 @@
+/*
+ LCD_i2c_dev.h
+
+ Linux transport for I2C_graphical_LCD_display: talks to the MCP23017 through /dev/i2c-N
+ (eg. on a Raspberry Pi or other single-board computer).
+
+ Each write transaction from the display becomes one i2c_msg, and the messages are queued up
+ rather than sent one at a time. They go out together, in a single I2C_RDWR ioctl, when:
+   * the display finishes a batch (or a write made outside a batch)
+   * a byte is read - the read is added to the end, so the writes before it and the read
+     share one ioctl (with repeated starts between them, rather than stops)
+   * the queue is full (the kernel takes at most 42 messages per ioctl)
+
+ So a batched clear of the whole screen is a handful of system calls rather than hundreds.
+
+ The bus clock is set by the kernel (eg. dtparam=i2c_arm_baudrate on a Pi), not by us.
+
+ Example:
+
+   LCD_i2c_dev bus;
+   I2C_graphical_LCD_display lcd;
+   if (!bus.open ("/dev/i2c-1"))
+     ...
+   lcd.setTransport (bus);
+   lcd.begin ();
+   ...
+   bus.endFrame ();   // once per screen update, if you want syscallsPerFrame
+   printf ("%.1f syscalls per frame\n", bus.syscallsPerFrame ());
+
+ Testing without hardware: the i2c-stub kernel module only does SMBus transfers, not
+ I2C_RDWR, so instead derive from this class and override transfer, which is given each
+ array of messages just as the kernel would be (eg. feed them to an LCD_emulator).
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_i2c_dev_H
+#define LCD_i2c_dev_H
+
+#include "LCD_host.h"
+
+#include <linux/i2c.h>
+
+#define LCD_I2C_DEV_MAX_MSGS  42     // I2C_RDWR_IOCTL_MAX_MSGS in the kernel
+#define LCD_I2C_DEV_BUFFER    4096   // bytes of messages we hold before sending them
+
+class LCD_i2c_dev : public LCD_transport
+{
+public:
+
+  struct Stats
+    {
+    unsigned long syscalls;   // ioctl calls
+    unsigned long messages;   // i2c messages (reads and writes) sent in them
+    unsigned long bytes;      // bytes written, including register bytes
+    unsigned long reads;      // bytes read
+    unsigned long errors;     // ioctl calls which failed
+    unsigned long frames;     // calls to endFrame
+    };
+
+  LCD_i2c_dev ();
+  virtual ~LCD_i2c_dev ();
+
+  boolean open (const char * device);   // eg. "/dev/i2c-1" - returns false on failure
+  void close ();
+
+  // LCD_transport
+  virtual void startSend (const byte port);
+  virtual void doSend (const byte what);
+  virtual byte endSend ();
+  virtual byte requestByte (const byte port);
+  virtual byte flush ();
+  virtual unsigned int maxTransaction () { return _maxTransaction; }
+
+  // longest write message; some I2C adapters can't do long ones, so reduce this if need be
+  void setMaxTransaction (const unsigned int bytes);
+
+  // statistics
+  const Stats & stats () const { return _stats; }
+  void resetStats ();
+  void endFrame () { _stats.frames++; }
+  double syscallsPerFrame () const;
+
+protected:
+
+  // send "count" messages - returns count, or -1 on error (as ioctl (fd, I2C_RDWR, ...))
+  virtual int transfer (struct i2c_msg * msgs, const unsigned int count);
+
+private:
+
+  void send ();   // send the queued messages; an error is kept for the next endSend or flush
+
+  int _fd;
+  struct i2c_msg _msgs [LCD_I2C_DEV_MAX_MSGS];
+  unsigned int _count;              // messages queued (including one being built)
+  byte _buffer [LCD_I2C_DEV_BUFFER];
+  unsigned int _used;               // bytes of _buffer in use
+  unsigned int _maxTransaction;
+  boolean _building;                // between startSend and endSend
+  byte _error;                      // to report at the next endSend or flush (as Wire.endTransmission)
+  byte _read;                       // where a read goes
+  Stats _stats;
+
+};  // end of class LCD_i2c_dev
+
+#endif  // LCD_i2c_dev_H
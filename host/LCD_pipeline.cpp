@@ -0,0 +1,110 @@
+/*
+ LCD_pipeline.cpp
+
+ Pipelined drawing for I2C_graphical_LCD_display on a Linux host - see LCD_pipeline.h
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "LCD_pipeline.h"
+
+#include <chrono>
+
+#define LCD_PIPELINE_FRESH  0x80   // in _middle: a frame which hasn't been sent yet
+#define LCD_PIPELINE_INDEX  0x03
+#define LCD_PIPELINE_IDLE   200    // microseconds the I/O thread sleeps when there is nothing new
+
+LCD_pipeline::LCD_pipeline (I2C_graphical_LCD_display & lcd) 
+  : _lcd (lcd), _shownValid (false), _back (0), _front (2), _middle (1), _running (false),
+    _submitted (0), _shownCount (0), _dropped (0), _sendMicros (0), _longestSend (0)
+{
+  memset (_frames, 0, sizeof _frames);
+  _canvas.setTarget (_frames [_back]);
+  _canvas.gotoxy (0, 0);
+}  // end of LCD_pipeline::LCD_pipeline
+
+LCD_pipeline::~LCD_pipeline ()
+{
+  stop ();
+}  // end of LCD_pipeline::~LCD_pipeline
+
+void LCD_pipeline::start ()
+{
+  if (_running)
+    return;
+  _shownValid = false;
+  _running = true;
+  _thread = std::thread (&LCD_pipeline::run, this);
+}  // end of LCD_pipeline::start
+
+void LCD_pipeline::stop ()
+{
+  if (!_running)
+    return;
+  _running = false;
+  _thread.join ();
+}  // end of LCD_pipeline::stop
+
+// drawing thread: publish the back frame, and carry on drawing in a copy of it
+void LCD_pipeline::submit ()
+{
+  byte done = _back;
+  byte old = _middle.exchange (done | LCD_PIPELINE_FRESH);
+  if (old & LCD_PIPELINE_FRESH)
+    _dropped++;
+  _submitted++;
+
+  // the I/O thread only reads the frame we just gave it, so we can copy from it
+  _back = old & LCD_PIPELINE_INDEX;
+  memcpy (_frames [_back], _frames [done], LCD_FRAME_SIZE);
+  _canvas.setTarget (_frames [_back]);
+}  // end of LCD_pipeline::submit
+
+// I/O thread: send the newest frame, if there is one - returns false if there wasn't
+boolean LCD_pipeline::sendNext ()
+{
+  if (!(_middle.load () & LCD_PIPELINE_FRESH))
+    return false;
+
+  // only the drawing thread makes frames fresh, so this one is still fresh
+  _front = _middle.exchange (_front) & LCD_PIPELINE_INDEX;
+
+  unsigned long start = micros ();
+  if (_shownValid)
+    _lcd.display (_frames [_front], _shown);
+  else
+    {
+    _lcd.display (_frames [_front]);
+    memcpy (_shown, _frames [_front], LCD_FRAME_SIZE);
+    _shownValid = true;
+    }
+  unsigned long taken = micros () - start;
+
+  _shownCount++;
+  _sendMicros += taken;
+  if (taken > _longestSend)
+    _longestSend = taken;
+  return true;
+}  // end of LCD_pipeline::sendNext
+
+void LCD_pipeline::run ()
+{
+  while (_running)
+    if (!sendNext ())
+      std::this_thread::sleep_for (std::chrono::microseconds (LCD_PIPELINE_IDLE));
+
+  // anything submitted just before we were stopped
+  sendNext ();
+}  // end of LCD_pipeline::run
+
+LCD_pipeline::Stats LCD_pipeline::stats () const
+{
+  Stats stats;
+  stats.submitted = _submitted;
+  stats.shown = _shownCount;
+  stats.dropped = _dropped;
+  stats.sendMicros = _sendMicros;
+  stats.longestSend = _longestSend;
+  return stats;
+}  // end of LCD_pipeline::stats
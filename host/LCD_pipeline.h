@@ -0,0 +1,104 @@
+/*
+ LCD_pipeline.h
+
+ Pipelined drawing for I2C_graphical_LCD_display on a Linux host: the program draws the next 
+ frame while a second thread sends the previous one to the LCD.
+
+ Frames are handed over through three frame buffers, without locks:
+   * the back frame - being drawn into (by the canvas)
+   * the middle frame - the most recently finished frame, waiting to be sent
+   * the front frame - being sent by the I/O thread (only the bytes which changed)
+
+ submit () swaps the back and middle frames. If the I/O thread hasn't taken the previous middle 
+ frame yet, that frame is dropped (it was never going to be seen for long anyway), so drawing never 
+ waits for the bus and the bus always sends the newest frame. The frame rate is then set by the 
+ slower of drawing and sending, rather than both added together.
+
+ Example:
+
+   LCD_emulator bus;            // or LCD_i2c_dev
+   I2C_graphical_LCD_display lcd;
+   lcd.setTransport (bus);
+   lcd.begin ();
+
+   LCD_pipeline pipeline (lcd);
+   pipeline.start ();
+   for (;;)
+     {
+     I2C_graphical_LCD_display & canvas = pipeline.canvas ();
+     canvas.clear ();
+     canvas.gotoxy (0, 0);
+     canvas.print (millis ());
+     pipeline.submit ();
+     }
+
+ Draw only with the canvas while the pipeline is running - lcd belongs to the I/O thread.
+ After submit the canvas holds a copy of the frame just submitted, so you can carry on from it.
+
+ Build with -pthread.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#ifndef LCD_pipeline_H
+#define LCD_pipeline_H
+
+#include "../I2C_graphical_LCD_display.h"
+
+#include <atomic>
+#include <thread>
+
+class LCD_pipeline
+{
+public:
+
+  struct Stats
+    {
+    unsigned long submitted;      // frames given to submit
+    unsigned long shown;          // frames sent to the LCD
+    unsigned long dropped;        // frames replaced by a newer one before they were sent
+    unsigned long sendMicros;     // total time spent sending
+    unsigned long longestSend;    // longest time to send one frame (microseconds)
+    };
+
+  LCD_pipeline (I2C_graphical_LCD_display & lcd);
+  ~LCD_pipeline ();
+
+  void start ();     // the first frame is sent in full (we don't know what the LCD shows)
+  void stop ();      // sends the last frame submitted, if it hasn't been already
+
+  I2C_graphical_LCD_display & canvas () { return _canvas; }
+  byte * frame () { return _frames [_back]; }
+  void submit ();
+
+  Stats stats () const;
+
+private:
+
+  void run ();
+  boolean sendNext ();
+
+  I2C_graphical_LCD_display & _lcd;
+  I2C_graphical_LCD_display _canvas;
+
+  byte _frames [3] [LCD_FRAME_SIZE];
+  byte _shown [LCD_FRAME_SIZE];
+  boolean _shownValid;
+
+  byte _back;                         // only used by the drawing thread
+  byte _front;                        // only used by the I/O thread
+  std::atomic <byte> _middle;         // frame index, plus LCD_PIPELINE_FRESH if not yet sent
+
+  std::atomic <bool> _running;
+  std::thread _thread;
+
+  std::atomic <unsigned long> _submitted;
+  std::atomic <unsigned long> _shownCount;
+  std::atomic <unsigned long> _dropped;
+  std::atomic <unsigned long> _sendMicros;
+  std::atomic <unsigned long> _longestSend;
+
+};  // end of class LCD_pipeline
+
+#endif  // LCD_pipeline_H
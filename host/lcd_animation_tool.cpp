@@ -0,0 +1,200 @@
+/*
+ lcd_animation_tool.cpp
+
+ Makes an LCD_animation container (see LCD_animation.h) from a series of PBM files, one per frame,
+ and writes it out as a C header:
+
+   lcd_animation_tool [-n name] [-t milliseconds] frame1.pbm frame2.pbm ... > name.h
+
+   -n name   the name of the PROGMEM array (default "animation")
+   -t ms     milliseconds per frame (default 100)
+
+ The frames must all be the same size: at most 128 x 64 pixels (the height is rounded up to whole
+ pages, with white below). Both plain (P1) and raw (P4) PBM files are read; 1 = black.
+
+ Build with (from the library folder):
+
+   g++ -I. -o lcd_animation_tool host/lcd_animation_tool.cpp LCD_animation.cpp I2C_graphical_LCD_display.cpp
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "../LCD_animation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <vector>
+
+// next number in a PBM header (skipping white space and comments) - -1 if there isn't one
+static int pbmNumber (FILE * f)
+{
+  int c = fgetc (f);
+  while (c != EOF && (isspace (c) || c == '#'))
+    {
+    if (c == '#')
+      while (c != EOF && c != '\n')
+        c = fgetc (f);
+    c = fgetc (f);
+    }
+
+  if (c == EOF || !isdigit (c))
+    return -1;
+
+  int n = 0;
+  while (c != EOF && isdigit (c))
+    {
+    n = n * 10 + c - '0';
+    c = fgetc (f);
+    }
+  return n;   // the one character after the number (white space) has been used up, as PBM wants
+}  // end of pbmNumber
+
+// read a PBM file into a frame (pages of column bytes) - false if it can't be read
+static bool readPBM (const char * name,
+                     int & w,
+                     int & h,
+                     std::vector <byte> & frame)
+{
+  FILE * f = fopen (name, "rb");
+  if (!f)
+    {
+    fprintf (stderr, "%s: can't open\n", name);
+    return false;
+    }
+
+  char magic [2] = { 0, 0 };
+  if (fread (magic, 1, 2, f) != 2 || magic [0] != 'P' || (magic [1] != '1' && magic [1] != '4'))
+    {
+    fprintf (stderr, "%s: not a PBM file (P1 or P4)\n", name);
+    fclose (f);
+    return false;
+    }
+
+  w = pbmNumber (f);
+  h = pbmNumber (f);
+  if (w <= 0 || h <= 0 || w > 128 || h > 64)
+    {
+    fprintf (stderr, "%s: must be 1 to 128 pixels wide and 1 to 64 high\n", name);
+    fclose (f);
+    return false;
+    }
+
+  // rows, leftmost pixel in the high bit, as importRows wants
+  int stride = (w + 7) / 8;
+  std::vector <byte> rows (stride * h, 0);
+  bool ok = true;
+  if (magic [1] == '4')
+    ok = fread (&rows [0], 1, rows.size (), f) == rows.size ();
+  else
+    for (int i = 0; i < w * h && ok; i++)
+      {
+      int c;
+      do
+        c = fgetc (f);
+      while (c != EOF && c != '0' && c != '1');
+      if (c == EOF)
+        ok = false;
+      else if (c == '1')
+        {
+        int x = i % w;
+        rows [(i / w) * stride + x / 8] |= 0x80 >> (x % 8);
+        }
+      }
+  fclose (f);
+
+  if (!ok)
+    {
+    fprintf (stderr, "%s: too short\n", name);
+    return false;
+    }
+
+  int pages = (h + 7) / 8;
+  frame.assign (w * pages, 0);
+  for (int page = 0; page < pages; page++)
+    {
+    int count = h - page * 8 < 8 ? h - page * 8 : 8;
+    I2C_graphical_LCD_display::importRows (&rows [page * 8 * stride], stride, w, &frame [page * w], count);
+    }
+  return true;
+}  // end of readPBM
+
+int main (int argc, char * argv [])
+{
+  const char * name = "animation";
+  int frameTime = 100;
+  int i = 1;
+
+  for ( ; i < argc && argv [i] [0] == '-'; i++)
+    {
+    if (argv [i] [1] == 'n' && i + 1 < argc)
+      name = argv [++i];
+    else if (argv [i] [1] == 't' && i + 1 < argc)
+      frameTime = atoi (argv [++i]);
+    else
+      break;
+    }
+
+  if (i >= argc || frameTime <= 0 || frameTime > 65535)
+    {
+    fprintf (stderr, "usage: lcd_animation_tool [-n name] [-t milliseconds] frame1.pbm frame2.pbm ... > name.h\n");
+    return 1;
+    }
+
+  // read all the frames
+  std::vector <std::vector <byte> > frames;
+  int w = 0, h = 0;
+  for ( ; i < argc; i++)
+    {
+    int fw = 0, fh = 0;
+    std::vector <byte> frame;
+    if (!readPBM (argv [i], fw, fh, frame))
+      return 1;
+    if (!frames.empty () && (fw != w || fh != h))
+      {
+      fprintf (stderr, "%s: is %d x %d, but the first frame is %d x %d\n", argv [i], fw, fh, w, h);
+      return 1;
+      }
+    w = fw;
+    h = fh;
+    frames.push_back (frame);
+    }
+
+  if (frames.size () > 65535)
+    {
+    fprintf (stderr, "too many frames\n");
+    return 1;
+    }
+
+  // header, keyframe, then a delta to each following frame (and from the last back to the first)
+  int pages = (h + 7) / 8;
+  std::vector <byte> out;
+  out.push_back (w);
+  out.push_back (pages);
+  out.push_back (frames.size () & 0xFF);
+  out.push_back (frames.size () >> 8);
+  out.push_back (frameTime & 0xFF);
+  out.push_back (frameTime >> 8);
+  out.insert (out.end (), frames [0].begin (), frames [0].end ());
+
+  std::vector <byte> delta (LCD_ANIM_MAX_DELTA (w, pages));
+  for (size_t f = 0; f < frames.size (); f++)
+    {
+    const std::vector <byte> & to = frames [(f + 1) % frames.size ()];
+    unsigned int size = LCD_animation::encodeDelta (&frames [f] [0], &to [0], w, pages, &delta [0]);
+    out.insert (out.end (), delta.begin (), delta.begin () + size);
+    }
+
+  printf ("// %s: %d x %d pixels, %d frames of %d ms - made by lcd_animation_tool\n",
+          name, w, h, (int) frames.size (), frameTime);
+  printf ("// %d bytes (%d as separate frames)\n\n", (int) out.size (), (int) (frames.size () * w * pages));
+  printf ("const byte %s [] PROGMEM = {\n", name);
+  for (size_t j = 0; j < out.size (); j++)
+    printf ("%s0x%02X,%s", j % 16 ? " " : "  ", out [j], j % 16 == 15 || j + 1 == out.size () ? "\n" : "");
+  printf ("};\n");
+
+  fprintf (stderr, "%s: %d frames, %d bytes (%d as separate frames)\n",
+           name, (int) frames.size (), (int) out.size (), (int) (frames.size () * w * pages));
+  return 0;
+}  // end of main
@@ -0,0 +1,120 @@
+/*
+ animation_test.cpp
+
+ Checks host/lcd_animation_tool end to end: this program writes a few small PBM frames, the
+ tool turns them into an LCD_animation container (a C header), and this program - built again,
+ with that header - plays it on LCD_emulator and checks each frame against the one it wrote.
+ "make" does all of that (see Makefile).
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "I2C_graphical_LCD_display.h"
+#include "LCD_animation.h"
+#include "host/LCD_emulator.h"
+
+#include <stdio.h>
+
+#define FRAMES  3
+#define WIDTH   20
+#define HEIGHT  12   // not whole pages: the tool rounds up, with white below
+
+// pixel x, y of frame f: a border, and a block moving across
+static bool black (const int f, const int x, const int y)
+{
+  if (x == 0 || y == 0 || x == WIDTH - 1 || y == HEIGHT - 1)
+    return true;
+  return x >= 2 + f * 5 && x < 8 + f * 5 && y >= 2 + f && y < 8 + f;
+}  // end of black
+
+#ifndef ANIMATION_HEADER
+
+// first build: write frame0.pbm ... into the folder given (the first plain, the rest raw)
+int main (int argc, char * argv [])
+{
+  if (argc < 2)
+    {
+    fprintf (stderr, "usage: animation_frames folder\n");
+    return 1;
+    }
+
+  for (int f = 0; f < FRAMES; f++)
+    {
+    char filename [200];
+    snprintf (filename, sizeof filename, "%s/frame%d.pbm", argv [1], f);
+    FILE * out = fopen (filename, "wb");
+    if (!out)
+      {
+      fprintf (stderr, "%s: can't write\n", filename);
+      return 1;
+      }
+    fprintf (out, "P%c\n# frame %d\n%d %d\n", f == 0 ? '1' : '4', f, WIDTH, HEIGHT);
+    for (int y = 0; y < HEIGHT; y++)
+      {
+      byte bits = 0;
+      for (int x = 0; x < WIDTH; x++)
+        if (f == 0)
+          fprintf (out, "%c%s", black (f, x, y) ? '1' : '0', x == WIDTH - 1 ? "\n" : " ");
+        else
+          {
+          if (black (f, x, y))
+            bits |= 0x80 >> (x % 8);
+          if (x % 8 == 7 || x == WIDTH - 1)
+            {
+            fputc (bits, out);
+            bits = 0;
+            }
+          }
+      }
+    fclose (out);
+    }
+  return 0;
+}  // end of main
+
+#else
+
+#include ANIMATION_HEADER
+
+// second build: play the tool's output, twice round, checking every frame
+int main ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+
+  const byte left = 50, page = 2;
+  LCD_animation anim (lcd, test_animation, left, page);
+  int failures = 0;
+
+  if (anim.frames () != FRAMES || anim.width () != WIDTH || anim.pages () != (HEIGHT + 7) / 8)
+    {
+    printf ("  FAIL: %u frames of %d x %d pages, expected %d of %d x %d\n",
+            anim.frames (), anim.width (), anim.pages (), FRAMES, WIDTH, (HEIGHT + 7) / 8);
+    failures++;
+    }
+
+  anim.begin ();
+  for (int step = 0; step <= 2 * FRAMES && !failures; step++)
+    {
+    unsigned int f = step % FRAMES;
+    int bad = 0;
+    for (int y = 0; y < anim.pages () * 8; y++)
+      for (int x = 0; x < WIDTH; x++)
+        if (emu.pixel (left + x, page * 8 + y) != (y < HEIGHT && black (f, x, y)))
+          bad++;
+    if (bad || anim.frame () != f)
+      {
+      printf ("  FAIL: step %d (frame %u, expected %u): %d pixels wrong\n", step, anim.frame (), f, bad);
+      failures++;
+      }
+    anim.showNext ();
+    }
+
+  printf ("animation (%u bytes, from lcd_animation_tool): %s\n", (unsigned) sizeof test_animation,
+          failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}  // end of main
+
+#endif // ANIMATION_HEADER
@@ -0,0 +1,1337 @@
+/*
+ lcd_tests.cpp
+
+ Regression tests for I2C_graphical_LCD_display, run on a Linux host against LCD_emulator.
+
+ Each test draws something, then checks what the emulated LCD shows - against a golden image
+ (in golden), against a simple model worked out pixel by pixel, or against the same thing drawn
+ another way - and, for the main drawing calls, that the bus traffic hasn't grown.
+
+   make              build and run (see Makefile)
+   make golden       rewrite the golden images (after a deliberate change to what is drawn)
+
+ The bus budgets below are what the code costs now: if a change makes drawing cheaper, lower them.
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "I2C_graphical_LCD_display.h"
+#include "LCD_animation.h"
+#include "LCD_big_number.h"
+#include "LCD_bitmap.h"
+#include "LCD_damage.h"
+#include "LCD_dither.h"
+#include "LCD_grayscale.h"
+#include "LCD_strip_chart.h"
+#include "host/LCD_emulator.h"
+#include "host/LCD_i2c_dev.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// bus budgets (transactions, and microseconds at the emulator's default 100 kHz)
+#define BUDGET_BEGIN_TRANSACTIONS   85
+#define BUDGET_BEGIN_MICROS_400K    52500     // clearing the screen, cold (after checking for warm)
+#define BUDGET_WARM_MICROS_400K     1500      // warm restart: checking, and leaving it alone
+#define BUDGET_DEMO_TRANSACTIONS    3220
+#define BUDGET_DEMO_MICROS          1720000
+
+static int failures;
+static int checks;
+static boolean update;              // rewriting the golden images
+static const char * goldenDir = "golden";
+
+#define CHECK(cond, ...) \
+  do { \
+    checks++; \
+    if (!(cond)) \
+      { \
+      failures++; \
+      printf ("  FAIL %s:%d: ", __FILE__, __LINE__); \
+      printf (__VA_ARGS__); \
+      printf ("\n"); \
+      } \
+  } while (0)
+
+static boolean pixel (const byte * frame, const int x, const int y)
+{
+  return (frame [(y >> 3) * 128 + x] >> (y & 7)) & 1;
+}  // end of pixel
+
+// fill both chips with junk, so tests can see what was (and wasn't) written
+static void scribble (LCD_emulator & emu)
+{
+  for (byte chip = 0; chip < 2; chip++)
+    for (byte page = 0; page < 8; page++)
+      for (byte addr = 0; addr < 64; addr++)
+        emu.setRam (chip, page, addr, rand ());
+}  // end of scribble
+
+// compare what the emulator shows with golden/<name>.pbm (or write it, with "make golden")
+static void golden (const LCD_emulator & emu, const char * name)
+{
+  char filename [200];
+  snprintf (filename, sizeof filename, "%s/%s.pbm", goldenDir, name);
+  if (update)
+    {
+    CHECK (emu.savePBM (filename), "can't write %s", filename);
+    return;
+    }
+  byte frame [LCD_EMULATOR_FRAME_SIZE];
+  if (!emu.loadPBM (filename, frame))
+    {
+    CHECK (false, "can't read %s", filename);
+    return;
+    }
+  unsigned int differ = emu.compare (frame);
+  CHECK (differ == 0, "%s: %u bytes differ from the golden image", name, differ);
+}  // end of golden
+
+const byte picture [] PROGMEM = {
+  0x1C, 0x22, 0x49, 0xA1, 0xA1, 0x49, 0x22, 0x1C,
+  0x10, 0x08, 0x04, 0x62, 0x62, 0x04, 0x08, 0x10,
+  0x4C, 0x52, 0x4C, 0x40, 0x5F, 0x44, 0x4A, 0x51,
+};
+
+LCD_BITMAP (face, 8, 8,
+  "..###..."
+  ".#...#.."
+  "#.....#."
+  "#..#..#."
+  "...#...."
+  "#..#..#."
+  ".#...#.."
+  "..###...");
+
+LCD_BITMAP (tall, 3, 11,
+  "#.#" ".#." "#.#" "..." "###" "#.." "..#" "###" "#.#" "..." "#..");
+
+// the original demo: every letter, clears, lines, rectangles, a blit
+static void drawDemo (I2C_graphical_LCD_display & lcd)
+{
+  for (int i = ' '; i <= 0x7F; i++)
+    lcd.letter (i);
+  lcd.clear (6, 40, 30, 63, 0xFF);
+  lcd.gotoxy (40, 40);
+  lcd.string ("Nick Gammon.", true);
+  lcd.gotoxy (40, 56);
+  lcd.blit (picture, sizeof picture);
+  lcd.frameRect (40, 49, 60, 53, 1, 1);
+  lcd.line (6, 40, 30, 63, 0);
+  lcd.line (100, 10, 70, 30, 1);
+  lcd.fillRect (90, 50, 110, 60, 1);
+  lcd.setPixel (127, 63, 1);
+  lcd.gotoxy (110, 32);
+  lcd.print ("wrap-text 123");
+}  // end of drawDemo
+
+// the newer calls
+static void drawFeatures (I2C_graphical_LCD_display & lcd)
+{
+  lcd.textBox (0, 0, 60, 24, "Word-wrapped text, justified in a box.", LCD_ALIGN_JUSTIFY);
+  lcd.fillPattern (64, 3, 95, 28, LCD_PATTERN_GREY25);
+  lcd.fillPattern (96, 3, 127, 28, LCD_PATTERN_CROSSHATCH);
+  lcd.bitmap (5, 29, face, face_width, face_height);
+  lcd.bitmap (20, 27, tall, tall_width, tall_height);
+  lcd.pushViewport (30, 32, 40, 20);
+  lcd.fillPattern (0, 0, 255, 255, LCD_PATTERN_GREY50);
+  lcd.gotoxy (2, 6);
+  lcd.string ("clipped text");
+  lcd.popViewport ();
+  lcd.gotoxy (80, 40);
+  lcd.printFixed (-1234, 2);
+}  // end of drawFeatures
+
+static void testGolden ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  CHECK (emu.stats ().transactions <= BUDGET_BEGIN_TRANSACTIONS,
+         "begin: %lu transactions (budget %d)", emu.stats ().transactions, BUDGET_BEGIN_TRANSACTIONS);
+
+  emu.resetStats ();
+  drawDemo (lcd);
+  golden (emu, "demo");
+  CHECK (emu.stats ().transactions <= BUDGET_DEMO_TRANSACTIONS,
+         "demo: %lu transactions (budget %d)", emu.stats ().transactions, BUDGET_DEMO_TRANSACTIONS);
+  CHECK (emu.busMicros () <= BUDGET_DEMO_MICROS,
+         "demo: %lu us on the bus (budget %d)", emu.busMicros (), BUDGET_DEMO_MICROS);
+
+  lcd.clear ();
+  drawFeatures (lcd);
+  golden (emu, "features");
+}  // end of testGolden
+
+// begin: a cold start clears the screen (within a time budget), a warm one leaves it alone
+static void testBegin ()
+{
+  LCD_emulator emu;
+  emu.setClock (400000);
+  scribble (emu);   // freshly powered: the RAM holds anything
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  CHECK (!lcd.begin (0x20, 0, 0, LCD_BEGIN_WARM), "begin: warm start detected on a fresh LCD");
+  byte blank [LCD_FRAME_SIZE];
+  memset (blank, 0, sizeof blank);
+  CHECK (emu.compare (blank) == 0, "begin: %u bytes not cleared", emu.compare (blank));
+  CHECK (emu.displayOn (0) && emu.displayOn (1), "begin: display not turned on");
+  CHECK (emu.busMicros () <= BUDGET_BEGIN_MICROS_400K, "begin: %lu us at 400 kHz (budget %d)",
+         emu.busMicros (), BUDGET_BEGIN_MICROS_400K);
+
+  // the processor restarts (eg. the watchdog), but the expander and LCD didn't lose power
+  drawDemo (lcd);
+  byte before [LCD_FRAME_SIZE];
+  emu.frame (before);
+  emu.resetStats ();
+  I2C_graphical_LCD_display restarted;
+  restarted.setTransport (emu);
+  CHECK (restarted.begin (0x20, 0, 0, LCD_BEGIN_WARM), "begin: warm start not detected");
+  CHECK (emu.compare (before) == 0, "begin: warm start changed %u bytes", emu.compare (before));
+  CHECK (emu.busMicros () <= BUDGET_WARM_MICROS_400K, "begin: warm start took %lu us at 400 kHz (budget %d)",
+         emu.busMicros (), BUDGET_WARM_MICROS_400K);
+
+  // power cycled: not warm, and with LCD_BEGIN_NO_CLEAR what is in the RAM is left there
+  emu.powerOn ();
+  I2C_graphical_LCD_display again;
+  again.setTransport (emu);
+  CHECK (!again.begin (0x20, 0, 0, LCD_BEGIN_WARM | LCD_BEGIN_NO_CLEAR), "begin: warm start detected after power-on");
+  CHECK (emu.compare (before) == 0, "begin: LCD_BEGIN_NO_CLEAR changed %u bytes", emu.compare (before));
+  CHECK (emu.displayOn (0) && emu.displayOn (1) && emu.startLine (0) == 0, "begin: display not set up");
+}  // end of testBegin
+
+// upside down, the LCD shows the same picture turned round (for at most a tenth more on the bus)
+static void testRotate180 ()
+{
+  LCD_emulator ea, eb;
+  I2C_graphical_LCD_display a, b;
+  a.setTransport (ea);
+  b.setTransport (eb);
+  a.setRotation (LCD_ROTATE_180);
+  a.begin ();
+  b.begin ();
+  ea.resetStats ();
+  eb.resetStats ();
+  drawDemo (a);
+  drawDemo (b);
+  drawFeatures (a);
+  drawFeatures (b);
+
+  byte fa [LCD_FRAME_SIZE], fb [LCD_FRAME_SIZE];
+  ea.frame (fa);
+  eb.frame (fb);
+  int bad = 0;
+  for (int y = 0; y < 64; y++)
+    for (int x = 0; x < 128; x++)
+      if (pixel (fa, 127 - x, 63 - y) != pixel (fb, x, y))
+        bad++;
+  CHECK (bad == 0, "180: %d pixels differ", bad);
+  CHECK (ea.stats ().bytes <= eb.stats ().bytes + eb.stats ().bytes / 10,
+         "180: %lu bytes, against %lu upright", ea.stats ().bytes, eb.stats ().bytes);
+}  // end of testRotate180
+
+// a pixel of a portrait frame (64 wide, 128 high: 16 pages of 64 bytes)
+static boolean portraitPixel (const byte * frame, const int x, const int y)
+{
+  return (frame [(y >> 3) * 64 + x] >> (y & 7)) & 1;
+}  // end of portraitPixel
+
+// where a portrait pixel appears on the LCD
+static void portraitToLcd (const byte rotation, const int x, const int y, int & lcdX, int & lcdY)
+{
+  if (rotation == LCD_ROTATE_90)    // top of the picture at the right-hand side
+    {
+    lcdX = 127 - y;
+    lcdY = x;
+    }
+  else                              // top at the left-hand side
+    {
+    lcdX = y;
+    lcdY = 63 - x;
+    }
+}  // end of portraitToLcd
+
+// text, a blit and the primitives, in 64 x 64 pixels from y = top
+static void drawSquare (I2C_graphical_LCD_display & lcd, const byte top)
+{
+  lcd.gotoxy (0, top);
+  lcd.string ("Portrait", true);
+  lcd.gotoxy (2, top + 8);
+  lcd.string ("text 0123");
+  lcd.gotoxy (30, top + 16);
+  lcd.blit (picture, sizeof picture);
+  lcd.line (0, top + 63, 63, top + 30, 1);
+  lcd.fillRect (5, top + 40, 25, top + 50, 1);
+  lcd.frameRect (30, top + 36, 60, top + 60, 1, 2);
+  lcd.clear (40, top + 24, 63, top + 31, 0x5A);
+  lcd.bitmap (3, top + 27, face, face_width, face_height);
+  lcd.setPixel (63, top + 63, 1);
+}  // end of drawSquare
+
+// portrait frames: drawing in them matches drawing in a landscape one (in the top and bottom
+// squares), and display turns them round - all of a frame, and only what changed (with "shown")
+static void testPortrait ()
+{
+  static byte landscape [LCD_FRAME_SIZE];
+  I2C_graphical_LCD_display flat;
+  memset (landscape, 0, sizeof landscape);
+  flat.setTarget (landscape);
+  drawSquare (flat, 0);
+
+  for (byte rotation = LCD_ROTATE_90; rotation <= LCD_ROTATE_270; rotation += 2)
+    {
+    LCD_emulator emu;
+    I2C_graphical_LCD_display lcd;
+    lcd.setTransport (emu);
+    lcd.setRotation (rotation);
+    lcd.begin ();
+
+    static byte frame [LCD_FRAME_SIZE], shown [LCD_FRAME_SIZE];
+    memset (frame, 0, sizeof frame);
+    lcd.setTarget (frame);
+    CHECK (lcd.width () == 64 && lcd.height () == 128, "portrait: %d x %d", lcd.width (), lcd.height ());
+    drawSquare (lcd, 0);
+    drawSquare (lcd, 64);
+    lcd.setTarget (NULL);
+
+    int bad = 0;
+    for (int y = 0; y < 128; y++)
+      for (int x = 0; x < 64; x++)
+        if (portraitPixel (frame, x, y) != pixel (landscape, x, y & 63))
+          bad++;
+    CHECK (bad == 0, "portrait (rotation %d): %d pixels drawn wrongly in the frame", rotation, bad);
+
+    // all of it, then random changes sent with "shown"
+    srand (rotation);
+    for (int pass = 0; pass < 2; pass++)
+      {
+      if (pass == 0)
+        lcd.display (frame);
+      else
+        {
+        memcpy (shown, frame, sizeof shown);
+        lcd.setTarget (frame);
+        for (int i = 0; i < 300; i++)
+          lcd.setPixel (rand () % 64, rand () % 128, rand () & 1);
+        lcd.gotoxy (8, 96);
+        lcd.string ("changed");
+        lcd.setTarget (NULL);
+        emu.resetStats ();
+        lcd.display (frame, shown);
+        CHECK (memcmp (shown, frame, sizeof frame) == 0, "portrait (rotation %d): shown not updated", rotation);
+        }
+
+      bad = 0;
+      for (int y = 0; y < 128; y++)
+        for (int x = 0; x < 64; x++)
+          {
+          int lcdX, lcdY;
+          portraitToLcd (rotation, x, y, lcdX, lcdY);
+          if (emu.pixel (lcdX, lcdY) != portraitPixel (frame, x, y))
+            bad++;
+          }
+      CHECK (bad == 0, "portrait (rotation %d, %s): %d pixels wrong on the LCD", rotation,
+             pass ? "changes" : "whole frame", bad);
+      }
+
+    // nothing changed: nothing sent
+    emu.resetStats ();
+    lcd.display (frame, shown);
+    CHECK (emu.stats ().dataWrites == 0, "portrait (rotation %d): %lu bytes sent for an unchanged frame",
+           rotation, emu.stats ().dataWrites);
+    }
+}  // end of testPortrait
+
+// clear, against a model: whole pages from the page of y1, every 8 rows while <= y2
+static void testClear ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  srand (1);
+  int bad = 0;
+  for (int t = 0; t < 3000; t++)
+    {
+    scribble (emu);
+    byte x1 = rand () % 128, x2 = x1 + rand () % (128 - x1), y1 = rand () % 64, y2 = y1 + rand () % (64 - y1);
+    byte val = rand ();
+    boolean inv = rand () & 1;
+    lcd.setInv (inv);
+    byte before [LCD_FRAME_SIZE], after [LCD_FRAME_SIZE];
+    emu.frame (before);
+    lcd.clear (x1, y1, x2, y2, val);
+    emu.frame (after);
+    for (int page = 0; page < 8; page++)
+      for (int x = 0; x < 128; x++)
+        {
+        boolean inside = x >= x1 && x <= x2 && page >= (y1 >> 3) && y1 + 8 * (page - (y1 >> 3)) <= y2;
+        byte want = inside ? (byte) (val ^ (inv ? 0xFF : 0)) : before [page * 128 + x];
+        if (after [page * 128 + x] != want)
+          bad++;
+        }
+    }
+  lcd.setInv (false);
+  CHECK (bad == 0, "clear: %d bytes wrong in 3000 random rectangles", bad);
+}  // end of testClear
+
+// bitmap at any position, against a model
+static void testBitmap ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  srand (5);
+  const byte * pics [] = { face, tall };
+  const byte widths [] = { face_width, tall_width };
+  const byte heights [] = { face_height, tall_height };
+  int bad = 0;
+  for (int t = 0; t < 400; t++)
+    {
+    scribble (emu);
+    int k = rand () % 2;
+    byte x = rand () % 128, y = rand () % 64;
+    boolean inv = rand () & 1;
+    lcd.setInv (inv);
+    byte before [LCD_FRAME_SIZE], after [LCD_FRAME_SIZE];
+    emu.frame (before);
+    lcd.bitmap (x, y, pics [k], widths [k], heights [k]);
+    emu.frame (after);
+    for (int yy = 0; yy < 64; yy++)
+      for (int xx = 0; xx < 128; xx++)
+        {
+        int bx = xx - x, by = yy - y;
+        boolean want;
+        if (bx >= 0 && bx < widths [k] && by >= 0 && by < heights [k])
+          want = ((pics [k] [(by >> 3) * widths [k] + bx] >> (by & 7)) & 1) ^ inv;
+        else
+          want = pixel (before, xx, yy);
+        if (pixel (after, xx, yy) != want)
+          bad++;
+        }
+    }
+  lcd.setInv (false);
+  CHECK (bad == 0, "bitmap: %d pixels wrong in 400 random placements", bad);
+}  // end of testBitmap
+
+// fillPattern against a model, upright and upside down, normal and inverse - and its cost
+static void testPattern ()
+{
+  for (byte rotation = LCD_ROTATE_0; rotation <= LCD_ROTATE_180; rotation += 2)
+    for (byte inv = 0; inv < 2; inv++)
+      {
+      LCD_emulator emu;
+      I2C_graphical_LCD_display lcd;
+      lcd.setTransport (emu);
+      lcd.setRotation (rotation);
+      lcd.begin ();
+      lcd.setInv (inv);
+      srand (7);
+      static byte model [LCD_FRAME_SIZE];
+      memset (model, inv ? 0xFF : 0, sizeof model);
+      lcd.clear ();
+      for (int t = 0; t < 300; t++)
+        {
+        int x1 = rand () % 128, y1 = rand () % 64;
+        int x2 = x1 + rand () % 140, y2 = y1 + rand () % 70;
+        if (x2 > 255)
+          x2 = 255;
+        if (y2 > 255)
+          y2 = 255;
+        const byte * pattern = LCD_patterns [rand () % 14];
+        lcd.fillPattern (x1, y1, x2, y2, pattern);
+        for (int y = y1; y <= y2 && y < 64; y++)
+          for (int x = x1; x <= x2 && x < 128; x++)
+            {
+            byte bit = 1 << (y & 7);
+            if (((pattern [x & 7] & bit) != 0) ^ inv)
+              model [(y >> 3) * 128 + x] |= bit;
+            else
+              model [(y >> 3) * 128 + x] &= ~bit;
+            }
+        }
+      byte frame [LCD_FRAME_SIZE];
+      emu.frame (frame);
+      int bad = 0;
+      for (int y = 0; y < 64; y++)
+        for (int x = 0; x < 128; x++)
+          if ((rotation == LCD_ROTATE_180 ? pixel (frame, 127 - x, 63 - y) : pixel (frame, x, y)) != pixel (model, x, y))
+            bad++;
+      CHECK (bad == 0, "fillPattern (rotation %d, inverse %d): %d pixels wrong", rotation, inv, bad);
+      }
+
+  // whole pages cost the same as clear
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  emu.resetStats ();
+  lcd.clear (10, 8, 29, 63, 0x55);
+  LCD_emulator::Stats cleared = emu.stats ();
+  emu.resetStats ();
+  lcd.fillPattern (10, 8, 29, 63, LCD_PATTERN_GREY25);
+  CHECK (emu.stats ().transactions == cleared.transactions && emu.stats ().bytes == cleared.bytes,
+         "fillPattern 20 x 56: %lu transactions %lu bytes, clear: %lu, %lu",
+         emu.stats ().transactions, emu.stats ().bytes, cleared.transactions, cleared.bytes);
+  emu.resetStats ();
+  lcd.clear ();
+  cleared = emu.stats ();
+  emu.resetStats ();
+  lcd.fillPattern (0, 0, 127, 63, LCD_PATTERN_CROSSHATCH);
+  CHECK (emu.stats ().bytes == cleared.bytes, "fillPattern screen: %lu bytes, clear: %lu",
+         emu.stats ().bytes, cleared.bytes);
+}  // end of testPattern
+
+// big digits going past the right-hand side or the bottom are cut off, not wrapped round
+static void testBigNumber ()
+{
+  struct { byte x, y, digits, height; } cases [] = {
+    { 100, 48, 5, 24 },    // off the right and the bottom
+    { 120, 48, 10, 24 },   // far enough right that the cells are past x = 255
+    { 40, 56, 4, 16 },     // off the bottom only
+  };
+
+  for (byte i = 0; i < sizeof cases / sizeof cases [0]; i++)
+    {
+    LCD_emulator emu;
+    I2C_graphical_LCD_display lcd;
+    lcd.setTransport (emu);
+    lcd.begin ();
+    LCD_big_number big (lcd, cases [i].x, cases [i].y, cases [i].digits, cases [i].height);
+    big.setNumber (888888888L);    // dashes if it doesn't fit: either way, every cell is drawn
+    big.setNumber (-888888888L);   // (and the first has a minus sign)
+
+    int outside = 0, inside = 0;
+    for (int y = 0; y < 64; y++)
+      for (int x = 0; x < 128; x++)
+        if (emu.pixel (x, y))
+          {
+          if (x < cases [i].x || y < cases [i].y)
+            outside++;
+          else
+            inside++;
+          }
+    CHECK (outside == 0, "big number at %d,%d: %d pixels wrapped round", cases [i].x, cases [i].y, outside);
+    CHECK (inside > 0, "big number at %d,%d: nothing drawn", cases [i].x, cases [i].y);
+    }
+}  // end of testBigNumber
+
+// a display list, a frame buffer and viewports all give the same picture as drawing directly
+static void testEquivalents ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  drawDemo (lcd);   // not drawFeatures: viewports aren't recorded
+  byte direct [LCD_FRAME_SIZE];
+  emu.frame (direct);
+
+  static byte list [2000];
+  lcd.clear ();
+  lcd.beginRecord (list, sizeof list);
+  drawDemo (lcd);
+  lcd.endRecord ();
+  CHECK (lcd.render (), "render: list overflowed");
+  CHECK (emu.compare (direct) == 0, "render: %u bytes differ from drawing directly", emu.compare (direct));
+
+  static byte frame [LCD_FRAME_SIZE], shown [LCD_FRAME_SIZE];
+  memset (frame, 0, sizeof frame);
+  lcd.setTarget (frame);
+  lcd.gotoxy (0, 0);
+  drawDemo (lcd);
+  lcd.setTarget (NULL);
+  CHECK (memcmp (frame, direct, sizeof frame) == 0, "frame buffer differs from drawing directly");
+
+  // display sends only what changed, and shown then matches
+  srand (3);
+  int bad = 0;
+  lcd.display (frame);
+  memcpy (shown, frame, sizeof shown);
+  for (int t = 0; t < 200; t++)
+    {
+    for (int i = 0; i < LCD_FRAME_SIZE; i++)
+      if (rand () % 7 == 0)
+        frame [i] = rand ();
+    lcd.display (frame, shown);
+    if (emu.compare (frame) || memcmp (shown, frame, sizeof frame))
+      bad++;
+    }
+  CHECK (bad == 0, "display: %d of 200 random frames wrong", bad);
+}  // end of testEquivalents
+
+// an animation made with encodeDelta plays back frame for frame, sending less than the keyframe
+static void testAnimation ()
+{
+  const byte w = 40, pages = 3, frames = 16;
+  std::vector <byte> pictures [frames];
+  for (int f = 0; f < frames; f++)
+    {
+    pictures [f].assign (w * pages, 0);
+    for (int x = 0; x < 8; x++)
+      for (int y = 0; y < 8; y++)
+        {
+        int px = f * 2 + x, py = (f * 5) % 16 + y;
+        pictures [f] [(py >> 3) * w + px] |= 1 << (py & 7);
+        }
+    }
+
+  std::vector <byte> data;
+  data.push_back (w);
+  data.push_back (pages);
+  data.push_back (frames);
+  data.push_back (0);
+  data.push_back (1);   // 1 ms a frame
+  data.push_back (0);
+  data.insert (data.end (), pictures [0].begin (), pictures [0].end ());
+  byte delta [LCD_ANIM_MAX_DELTA (40, 3)];
+  for (int f = 0; f < frames; f++)
+    {
+    unsigned int size = LCD_animation::encodeDelta (&pictures [f] [0], &pictures [(f + 1) % frames] [0], w, pages, delta);
+    data.insert (data.end (), delta, delta + size);
+    }
+  CHECK (data.size () < frames * w * pages / 2, "animation: %u bytes for %d frames", (unsigned) data.size (), frames);
+
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  LCD_animation anim (lcd, &data [0], 50, 3);
+  emu.resetStats ();
+  anim.begin ();
+  unsigned long keyBytes = emu.stats ().bytes;
+  int bad = 0;
+  unsigned long deltaBytes = 0;
+  for (int step = 0; step < 2 * frames; step++)
+    {
+    byte frame [LCD_FRAME_SIZE];
+    emu.frame (frame);
+    const std::vector <byte> & want = pictures [anim.frame ()];
+    for (int page = 0; page < pages; page++)
+      if (memcmp (&frame [(3 + page) * 128 + 50], &want [page * w], w))
+        bad++;
+    emu.resetStats ();
+    anim.showNext ();
+    deltaBytes += emu.stats ().bytes;
+    }
+  CHECK (bad == 0, "animation: %d pages wrong", bad);
+  CHECK (deltaBytes / (2 * frames) < keyBytes / 2, "animation: %lu bytes a frame, keyframe %lu",
+         deltaBytes / (2 * frames), keyBytes);
+}  // end of testAnimation
+
+// each grey level is black for that many frames of the cycle
+static void testGrayscale ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  static byte planes [LCD_GRAY_SIZE (64, 2)];
+  LCD_grayscale gray (lcd, planes, 32, 2, 64, 2);
+  gray.begin (1000);
+  for (byte level = 0; level < 4; level++)
+    gray.fillRect (level * 16, 0, level * 16 + 15, 15, level);
+
+  int black [64] [16];
+  memset (black, 0, sizeof black);
+  for (int f = 0; f < LCD_GRAY_FRAMES; f++)
+    {
+    while (!gray.service ())
+      {}
+    byte frame [LCD_FRAME_SIZE];
+    emu.frame (frame);
+    for (int x = 0; x < 64; x++)
+      for (int y = 0; y < 16; y++)
+        black [x] [y] += pixel (frame, 32 + x, 16 + y);
+    }
+  int bad = 0;
+  for (int x = 0; x < 64; x++)
+    for (int y = 0; y < 16; y++)
+      if (black [x] [y] != x / 16)
+        bad++;
+  CHECK (bad == 0, "grayscale: %d pixels have the wrong level", bad);
+
+  // nothing changes in white and black areas, so a white screen sends nothing
+  gray.clear ();
+  for (int f = 0; f < LCD_GRAY_FRAMES; f++)
+    while (!gray.service ())
+      {}
+  gray.resetStats ();
+  for (int f = 0; f < LCD_GRAY_FRAMES; f++)
+    while (!gray.service ())
+      {}
+  CHECK (gray.stats ().bytes == 0, "grayscale: %lu bytes sent for a white area", gray.stats ().bytes);
+}  // end of testGrayscale
+
+// an urgent region goes before the rest of a full-screen redraw
+static void testDamage ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  static byte frame [LCD_FRAME_SIZE], shown [LCD_FRAME_SIZE];
+  LCD_damage damage (lcd, frame, shown);
+
+  lcd.setTarget (frame);
+  lcd.gotoxy (0, 0);
+  drawDemo (lcd);
+  lcd.setTarget (NULL);
+  damage.damage (0, 0, 127, 63);
+  damage.flush (1);   // one page
+
+  lcd.setTarget (frame);
+  lcd.clear (0, 56, 127, 63, 0xFF);
+  lcd.setTarget (NULL);
+  damage.damage (0, 56, 127, 63, 200, 50);
+  damage.flush (1);
+  byte now [LCD_FRAME_SIZE];
+  emu.frame (now);
+  CHECK (memcmp (&now [7 * 128], &frame [7 * 128], 128) == 0, "damage: the urgent page wasn't sent next");
+  CHECK (damage.stats ().preempted == 1, "damage: %lu preempted", damage.stats ().preempted);
+
+  damage.flush ();
+  CHECK (emu.compare (frame) == 0, "damage: %u bytes wrong after flushing", emu.compare (frame));
+  CHECK (damage.stats ().missed == 0, "damage: %lu deadlines missed", damage.stats ().missed);
+}  // end of testDamage
+
+// nested viewports move and clip drawing, and popping goes back to each one in turn
+static void testViewports ()
+{
+  LCD_emulator ea, eb;
+  I2C_graphical_LCD_display a, b;
+  a.setTransport (ea);
+  b.setTransport (eb);
+  a.begin ();
+  b.begin ();
+
+  // the same drawing, directly in screen coordinates
+  b.fillRect (10, 8, 69, 55, 1);
+  b.fillRect (30, 16, 49, 23, 0);
+  b.fillRect (12, 50, 14, 52, 0);
+
+  boolean pushed = a.pushViewport (10, 8, 60, 48);
+  if (LCD_VIEWPORT_DEPTH == 0)
+    {
+    CHECK (!pushed, "viewports: pushed with LCD_VIEWPORT_DEPTH 0");
+    return;
+    }
+  a.fillRect (0, 0, 255, 255, 1);
+  boolean nested = a.pushViewport (20, 8, 20, 8);
+  CHECK (nested == (LCD_VIEWPORT_DEPTH > 1), "viewports: nested push %s", nested ? "worked" : "failed");
+  if (!nested)
+    return;
+  a.fillRect (0, 0, 100, 100, 0);
+  a.popViewport ();
+  a.fillRect (2, 42, 4, 44, 0);   // the first viewport again
+  a.popViewport ();
+
+  byte fb [LCD_FRAME_SIZE];
+  eb.frame (fb);
+  CHECK (ea.compare (fb) == 0, "viewports: %u bytes differ from drawing directly", ea.compare (fb));
+}  // end of testViewports
+
+// verify finds a damaged page, and rewrites just that one
+static void testVerify ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  static byte reference [LCD_FRAME_SIZE];
+  lcd.setReference (reference);
+  drawDemo (lcd);
+  byte before [LCD_FRAME_SIZE];
+  emu.frame (before);
+
+  CHECK (lcd.verify (16) == 0, "verify: repaired an undamaged screen");
+  emu.setRam (1, 5, 20, emu.ram (1, 5, 20) ^ 0x24);
+  byte repaired = lcd.verify (16);
+  CHECK (repaired == 1, "verify: repaired %d pages, expected 1", repaired);
+  CHECK (emu.compare (before) == 0, "verify: %u bytes still wrong", emu.compare (before));
+}  // end of testVerify
+
+// reads go wrong above a given clock
+class LCD_flaky : public LCD_emulator
+{
+public:
+  LCD_flaky (const unsigned long limit) : _limit (limit), _clock (100000) { }
+  virtual void setClock (const unsigned long clock) { _clock = clock; LCD_emulator::setClock (clock); }
+  virtual byte requestByte (const byte port)
+    {
+    byte b = LCD_emulator::requestByte (port);
+    return _clock > _limit ? b ^ 0x10 : b;
+    }
+private:
+  unsigned long _limit;
+  unsigned long _clock;
+};  // end of class LCD_flaky
+
+// autotune: one step slower than the fastest clock which works, and the screen left as it was
+static void testAutotune ()
+{
+  const unsigned long limits [] = { 100000, 600000, 5000000 };
+  const unsigned long expect [] = { 100000, 400000, 1000000 };   // 5 MHz: everything passes, so not 1.7 MHz
+
+  for (byte i = 0; i < 3; i++)
+    {
+    LCD_flaky emu (limits [i]);
+    I2C_graphical_LCD_display lcd;
+    lcd.setTransport (emu);
+    lcd.begin ();
+    drawDemo (lcd);
+    byte before [LCD_FRAME_SIZE];
+    emu.frame (before);
+    CHECK (lcd.autotune (), "autotune (limit %lu): failed", limits [i]);
+    CHECK (lcd.busClock () == expect [i], "autotune (limit %lu): %lu Hz, expected %lu",
+           limits [i], lcd.busClock (), expect [i]);
+    CHECK (emu.compare (before) == 0, "autotune (limit %lu): the screen wasn't put back", limits [i]);
+    }
+
+  I2C_graphical_LCD_display lcd;
+  lcd.setSpeed (5000000, LCD_BUSY_DELAY);
+  CHECK (lcd.busClock () == LCD_MAX_CLOCK, "setSpeed: %lu Hz, above LCD_MAX_CLOCK", lcd.busClock ());
+}  // end of testAutotune
+
+// LCD_i2c_dev, with the emulator standing in for /dev/i2c-N: each queued message goes to it
+class LCD_i2c_stand_in : public LCD_i2c_dev
+{
+public:
+  LCD_i2c_stand_in () : _fail (false) { _emu.setMaxTransaction (LCD_I2C_DEV_BUFFER); }
+  LCD_emulator & emu () { return _emu; }
+  void failNext () { _fail = true; }   // the next ioctl fails (as a NAK would make it)
+protected:
+  virtual int transfer (struct i2c_msg * msgs, const unsigned int count)
+    {
+    if (_fail)
+      {
+      _fail = false;
+      return -1;
+      }
+    for (unsigned int i = 0; i < count; i++)
+      if (msgs [i].flags & I2C_M_RD)
+        msgs [i].buf [0] = _emu.requestByte (msgs [i].addr);
+      else
+        {
+        _emu.startSend (msgs [i].addr);
+        for (unsigned int j = 0; j < msgs [i].len; j++)
+          _emu.doSend (msgs [i].buf [j]);
+        if (_emu.endSend ())
+          return -1;
+        }
+    return count;
+    }
+private:
+  LCD_emulator _emu;
+  boolean _fail;
+};  // end of class LCD_i2c_stand_in
+
+// the Linux transport draws the same picture, a read shares the ioctl of the writes before it,
+// and a failed ioctl is reported - even one made while queueing, rather than by flush
+static void testI2cDev ()
+{
+  LCD_i2c_stand_in bus;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (bus);
+  lcd.begin ();
+  drawDemo (lcd);
+  golden (bus.emu (), "demo");
+  CHECK (bus.stats ().errors == 0, "i2c-dev: %lu errors drawing", bus.stats ().errors);
+
+  // one read: one syscall, with the write queued before it
+  bus.resetStats ();
+  bus.startSend (0x20);
+  bus.doSend (0x12);
+  bus.endSend ();
+  bus.requestByte (0x20);
+  CHECK (bus.stats ().syscalls == 1 && bus.stats ().messages == 2,
+         "i2c-dev: a write and a read took %lu syscalls, %lu messages", bus.stats ().syscalls, bus.stats ().messages);
+
+  byte buf [16], shown [LCD_FRAME_SIZE];
+  lcd.readRegion (10, 8, 16, 1, buf);
+  bus.emu ().frame (shown);
+  CHECK (memcmp (buf, &shown [128 + 10], 16) == 0, "i2c-dev: readRegion read the wrong bytes");
+
+  // errors: from flush ...
+  bus.startSend (0x20);
+  bus.doSend (0x12);
+  CHECK (bus.endSend () == 0, "i2c-dev: endSend reported an error before sending");
+  bus.failNext ();
+  CHECK (bus.flush () != 0, "i2c-dev: flush didn't report a failed ioctl");
+  CHECK (bus.flush () == 0, "i2c-dev: flush reported the error twice");
+
+  // ... and from a send made because the queue was full
+  for (int i = 0; i < LCD_I2C_DEV_MAX_MSGS; i++)
+    {
+    bus.startSend (0x20);
+    bus.doSend (0x12);
+    bus.endSend ();
+    }
+  bus.failNext ();
+  bus.startSend (0x20);   // sends the full queue
+  bus.doSend (0x12);
+  CHECK (bus.endSend () != 0, "i2c-dev: the error from sending a full queue was lost");
+  bus.flush ();
+
+  // the display hears about it, in a batch too long for one ioctl
+  unsigned long before = lcd.busErrors ();
+  bus.resetStats ();
+  bus.failNext ();
+  lcd.beginBatch ();
+  for (int i = 0; i < 200; i++)
+    lcd.letter ('A');
+  lcd.endBatch ();
+  CHECK (bus.stats ().errors == 1, "i2c-dev: %lu failed ioctls, expected 1", bus.stats ().errors);
+  CHECK (lcd.busErrors () == before + 1, "i2c-dev: the display saw %lu errors, expected 1",
+         lcd.busErrors () - before);
+}  // end of testI2cDev
+
+// one column of a strip chart: a vertical line from the previous sample to this one
+static boolean chartPixel (const byte value, const byte previous, const int height, const int row)
+{
+  if (value == LCD_CHART_NONE)
+    return false;
+  int lo = value, hi = value;
+  if (previous != LCD_CHART_NONE)
+    {
+    if (previous < lo)
+      lo = previous;
+    else
+      hi = previous;
+    }
+  return row >= height - 1 - hi && row <= height - 1 - lo;
+}  // end of chartPixel
+
+// strip chart, sweeping and re-packing, against a model - and only changed bytes are sent
+static void testStripChart ()
+{
+  const byte cx = 10, cwidth = 100, cpage = 2, cpages = 5, cheight = cpages * 8;
+  for (byte keep = 0; keep <= 30; keep += 30)
+    {
+    LCD_emulator emu;
+    I2C_graphical_LCD_display lcd;
+    lcd.setTransport (emu);
+    lcd.begin ();
+    srand (7 + keep);
+    scribble (emu);
+    byte outside [LCD_FRAME_SIZE];
+    emu.frame (outside);
+
+    LCD_strip_chart chart (lcd, cx, cwidth, cpage, cpages, keep);
+    chart.begin ();
+
+    // the model: the sample shown in each column, and the one it is joined to
+    byte shown [128], joined [128];
+    memset (shown, LCD_CHART_NONE, sizeof shown);
+    memset (joined, LCD_CHART_NONE, sizeof joined);
+    byte last = LCD_CHART_NONE;
+    int column = 0;
+
+    int bad = 0, badSent = 0;
+    for (int n = 0; n < 350; n++)
+      {
+      byte value = rand () % (cheight + 10);   // some too high, to be clipped
+      if (value >= cheight)
+        value = cheight - 1;
+      if (column >= cwidth)
+        {
+        if (keep)
+          {
+          memmove (shown, &shown [cwidth - keep], keep);
+          memset (&shown [keep], LCD_CHART_NONE, cwidth - keep);
+          column = keep;
+          }
+        else
+          column = 0;
+        }
+      shown [column] = value;
+      joined [column] = last;
+      column++;
+      last = value;
+      if (keep)
+        for (int x = 0; x < cwidth; x++)
+          joined [x] = x ? shown [x - 1] : LCD_CHART_NONE;
+
+      byte before [LCD_FRAME_SIZE], after [LCD_FRAME_SIZE];
+      emu.frame (before);
+      emu.resetStats ();
+      chart.add (value);
+      emu.frame (after);
+
+      unsigned long changed = 0;
+      for (int i = 0; i < LCD_FRAME_SIZE; i++)
+        if (before [i] != after [i])
+          changed++;
+      // a sweep sends just the changed bytes (a re-pack redraws the whole chart)
+      if (!(keep && column == keep + 1) && emu.stats ().dataWrites != changed)
+        badSent++;
+
+      for (int y = 0; y < 64; y++)
+        for (int x = 0; x < 128; x++)
+          {
+          int row = y - cpage * 8;
+          boolean want;
+          if (x >= cx && x < cx + cwidth && row >= 0 && row < cheight)
+            want = chartPixel (shown [x - cx], joined [x - cx], cheight, row);
+          else
+            want = pixel (outside, x, y);
+          if (pixel (after, x, y) != want)
+            bad++;
+          }
+      }
+    CHECK (bad == 0, "strip chart (keep %d): %d pixels wrong in 350 samples", keep, bad);
+    CHECK (badSent == 0, "strip chart (keep %d): %d samples sent more than the changed bytes", keep, badSent);
+
+    // re-packing, redrawing shows the same thing (sweeping, column 0 is joined across the wrap)
+    if (keep)
+      {
+      byte before [LCD_FRAME_SIZE];
+      emu.frame (before);
+      chart.redraw ();
+      CHECK (emu.compare (before) == 0, "strip chart (keep %d): redraw changed %u bytes", keep, emu.compare (before));
+      }
+    }
+}  // end of testStripChart
+
+// collects what is printed (eg. a screenshot)
+class LCD_capture : public Print
+{
+public:
+  std::string text;
+  using Print::write;
+  virtual size_t write (uint8_t c) { text += (char) c; return 1; }
+};  // end of class LCD_capture
+
+// read a P1 or P4 image back: pixels [y * w + x], true = black
+static boolean parsePBM (const std::string & text, int & w, int & h, std::vector <boolean> & pixels)
+{
+  char magic [3];
+  int used;
+  if (sscanf (text.c_str (), "%2s %d %d%n", magic, &w, &h, &used) != 3)
+    return false;
+  pixels.assign (w * h, false);
+  const char * p = text.c_str () + used + 1;   // one whitespace character after the height
+  const char * end = text.c_str () + text.size ();
+  if (strcmp (magic, "P4") == 0)
+    {
+    int rowBytes = (w + 7) / 8;
+    if (end - p != rowBytes * h)
+      return false;
+    for (int y = 0; y < h; y++)
+      for (int x = 0; x < w; x++)
+        pixels [y * w + x] = (p [y * rowBytes + x / 8] >> (7 - (x & 7))) & 1;
+    return true;
+    }
+  if (strcmp (magic, "P1") != 0)
+    return false;
+  int n = 0;
+  for ( ; p < end; p++)
+    if (*p == '0' || *p == '1')
+      {
+      if (n >= w * h)
+        return false;
+      pixels [n++] = *p == '1';
+      }
+    else if (*p != '\n' && *p != ' ')
+      return false;
+  return n == w * h;
+}  // end of parsePBM
+
+// readRegion, writePBM and screenshot give back what the LCD shows
+static void testReadBack ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  drawDemo (lcd);
+  byte frame [LCD_FRAME_SIZE];
+  emu.frame (frame);
+
+  // random regions, some across the join between the chips
+  srand (11);
+  int bad = 0;
+  for (int t = 0; t < 300; t++)
+    {
+    byte x = rand () % 128, w = 1 + rand () % (128 - x), page = rand () % 8, pages = 1 + rand () % (8 - page);
+    if (t < 20)
+      {
+      x = 60 + rand () % 4;   // straddling column 64
+      w = 8;
+      }
+    byte buf [LCD_FRAME_SIZE];
+    lcd.readRegion (x, page * 8, w, pages, buf);
+    for (int p = 0; p < pages; p++)
+      for (int i = 0; i < w; i++)
+        if (buf [p * w + i] != frame [(page + p) * 128 + x + i])
+          bad++;
+    }
+  CHECK (bad == 0, "readRegion: %d bytes wrong in 300 random regions", bad);
+  CHECK (emu.compare (frame) == 0, "readRegion changed the screen");
+
+  // screenshots, binary and ascii
+  for (byte ascii = 0; ascii < 2; ascii++)
+    {
+    LCD_capture out;
+    lcd.screenshot (out, ascii);
+    int w, h;
+    std::vector <boolean> pixels;
+    if (!parsePBM (out.text, w, h, pixels) || w != 128 || h != 64)
+      {
+      CHECK (false, "screenshot (%s): not a 128 x 64 PBM", ascii ? "P1" : "P4");
+      continue;
+      }
+    int wrong = 0;
+    for (int y = 0; y < 64; y++)
+      for (int x = 0; x < 128; x++)
+        if (pixels [y * 128 + x] != pixel (frame, x, y))
+          wrong++;
+    CHECK (wrong == 0, "screenshot (%s): %d pixels wrong", ascii ? "P1" : "P4", wrong);
+    }
+
+  // writePBM of a small buffer: width not a multiple of 8, P1 lines split at 64 pixels
+  const byte sizes [] [2] = { { 20, 2 }, { 70, 1 } };
+  for (byte s = 0; s < 2; s++)
+    for (byte ascii = 0; ascii < 2; ascii++)
+      {
+      byte w = sizes [s] [0], pages = sizes [s] [1];
+      byte buf [140];
+      for (int i = 0; i < w * pages; i++)
+        buf [i] = rand ();
+      LCD_capture out;
+      I2C_graphical_LCD_display::writePBM (out, buf, w, pages, ascii);
+      int pw, ph;
+      std::vector <boolean> pixels;
+      if (!parsePBM (out.text, pw, ph, pixels) || pw != w || ph != pages * 8)
+        {
+        CHECK (false, "writePBM (%d x %d, %s): not a PBM of that size", w, pages * 8, ascii ? "P1" : "P4");
+        continue;
+        }
+      int wrong = 0;
+      for (int y = 0; y < ph; y++)
+        for (int x = 0; x < pw; x++)
+          if (pixels [y * pw + x] != ((buf [(y >> 3) * w + x] >> (y & 7)) & 1))
+            wrong++;
+      CHECK (wrong == 0, "writePBM (%d x %d, %s): %d pixels wrong", w, pages * 8, ascii ? "P1" : "P4", wrong);
+      }
+}  // end of testReadBack
+
+// dither one image (rows of width grays) at x, page, and return the screen
+static void dither (LCD_emulator & emu, I2C_graphical_LCD_display & lcd, const byte method,
+                    const byte x, const byte page, const byte width, const int rows,
+                    const byte * gray, byte * after)
+{
+  LCD_dither image (lcd, x, page, width, method);
+  image.begin ();
+  for (int y = 0; y < rows; y++)
+    image.addRow (&gray [y * width]);
+  image.end ();
+  emu.frame (after);
+}  // end of dither
+
+// all three dithering methods: threshold and Bayer against models, Floyd-Steinberg by density
+static void testDither ()
+{
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  srand (13);
+  static byte gray [64 * 128];
+  byte before [LCD_FRAME_SIZE], after [LCD_FRAME_SIZE];
+
+  // threshold, part of the screen and part of a page (the rest of that page is white), on junk
+  const byte tx = 10, tpage = 2, twidth = 100, trows = 29;
+  for (int i = 0; i < trows * twidth; i++)
+    gray [i] = rand ();
+  scribble (emu);
+  emu.frame (before);
+  emu.resetStats ();
+  dither (emu, lcd, LCD_DITHER_THRESHOLD, tx, tpage, twidth, trows, gray, after);
+  int bad = 0;
+  for (int y = 0; y < 64; y++)
+    for (int x = 0; x < 128; x++)
+      {
+      int row = y - tpage * 8, col = x - tx;
+      boolean want;
+      if (col >= 0 && col < twidth && row >= 0 && row < 32)
+        want = row < trows && gray [row * twidth + col] < 128;
+      else
+        want = pixel (before, x, y);
+      if (pixel (after, x, y) != want)
+        bad++;
+      }
+  CHECK (bad == 0, "dither (threshold): %d pixels wrong", bad);
+  CHECK (emu.stats ().dataWrites == 4 * twidth, "dither (threshold): %lu bytes sent, expected %d",
+         emu.stats ().dataWrites, 4 * twidth);
+
+  // Bayer: in each 8 x 8 block, gray g gives one black pixel for each threshold (4t + 2) above it
+  const byte levels [] = { 0, 1, 37, 100, 128, 200, 254, 255 };
+  for (byte l = 0; l < sizeof levels; l++)
+    {
+    memset (gray, levels [l], 64 * 128);
+    dither (emu, lcd, LCD_DITHER_BAYER, 0, 0, 128, 64, gray, after);
+    int want = 0;
+    for (int t = 0; t < 64; t++)
+      if (4 * t + 2 > levels [l])
+        want++;
+    int wrong = 0;
+    for (int by = 0; by < 64; by += 8)
+      for (int bx = 0; bx < 128; bx += 8)
+        {
+        int black = 0;
+        for (int y = by; y < by + 8; y++)
+          for (int x = bx; x < bx + 8; x++)
+            black += pixel (after, x, y);
+        if (black != want)
+          wrong++;
+        }
+    CHECK (wrong == 0, "dither (Bayer, gray %d): %d blocks without %d black pixels", levels [l], wrong, want);
+    }
+
+  // Bayer doesn't crawl: changing one pixel of the image changes only that pixel on the screen
+  for (int i = 0; i < 64 * 128; i++)
+    gray [i] = rand ();
+  dither (emu, lcd, LCD_DITHER_BAYER, 0, 0, 128, 64, gray, before);
+  int moved = 0;
+  for (int t = 0; t < 20; t++)
+    {
+    int x = rand () % 128, y = rand () % 64;
+    gray [y * 128 + x] ^= 0x80;
+    dither (emu, lcd, LCD_DITHER_BAYER, 0, 0, 128, 64, gray, after);
+    for (int i = 0; i < LCD_FRAME_SIZE; i++)
+      if (i != (y >> 3) * 128 + x && after [i] != before [i])
+        moved++;
+    gray [y * 128 + x] ^= 0x80;
+    }
+  CHECK (moved == 0, "dither (Bayer): %d bytes changed away from the pixel changed", moved);
+
+  // Floyd-Steinberg: the right proportion of black, for flat grays
+  const byte flat [] = { 0, 32, 96, 160, 224, 255 };
+  for (byte l = 0; l < sizeof flat; l++)
+    {
+    memset (gray, flat [l], 64 * 128);
+    dither (emu, lcd, LCD_DITHER_FLOYD, 0, 0, 128, 64, gray, after);
+    int black = 0;
+    for (int y = 0; y < 64; y++)
+      for (int x = 0; x < 128; x++)
+        black += pixel (after, x, y);
+    int want = (255 - flat [l]) * 64 * 128 / 255;
+    CHECK (abs (black - want) <= 64 * 128 / 50, "dither (Floyd-Steinberg, gray %d): %d black pixels, expected about %d",
+           flat [l], black, want);
+    }
+}  // end of testDither
+
+// importRows (with whichever transpose8 this was built with) and blitRows, against a naive transpose
+static void testImportRows ()
+{
+  srand (17);
+  int bad = 0;
+  for (int t = 0; t < 2000; t++)
+    {
+    byte w = 1 + rand () % 128, count = 1 + rand () % 8;
+    unsigned int stride = (w + 7) / 8 + rand () % 4;
+    byte rows [8 * 20];
+    for (unsigned int i = 0; i < sizeof rows; i++)
+      rows [i] = rand ();
+    byte page [128 + 1];
+    page [w] = 0x5A;   // guard
+    I2C_graphical_LCD_display::importRows (rows, stride, w, page, count);
+    for (int x = 0; x < w; x++)
+      {
+      byte want = 0;
+      for (int r = 0; r < count; r++)
+        if ((rows [r * stride + x / 8] >> (7 - (x & 7))) & 1)
+          want |= 1 << r;
+      if (page [x] != want)
+        bad++;
+      }
+    if (page [w] != 0x5A)
+      bad++;
+    }
+  CHECK (bad == 0, "importRows: %d columns wrong in 2000 random imports", bad);
+
+  // blitRows, rounding y down to a page and clipping at the right
+  LCD_emulator emu;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (emu);
+  lcd.begin ();
+  const byte places [] [4] = { { 5, 9, 120, 50 }, { 100, 16, 60, 21 }, { 0, 0, 128, 64 } };   // x, y, w, h
+  for (byte k = 0; k < 3; k++)
+    {
+    byte x = places [k] [0], y = places [k] [1], w = places [k] [2], h = places [k] [3];
+    unsigned int stride = (w + 7) / 8;
+    static byte rows [64 * 16];
+    for (unsigned int i = 0; i < sizeof rows; i++)
+      rows [i] = rand ();
+    scribble (emu);
+    byte before [LCD_FRAME_SIZE], after [LCD_FRAME_SIZE];
+    emu.frame (before);
+    lcd.blitRows (x, y, rows, stride, w, h);
+    emu.frame (after);
+    int wrong = 0;
+    for (int yy = 0; yy < 64; yy++)
+      for (int xx = 0; xx < 128; xx++)
+        {
+        int bx = xx - x, by = yy - (y & ~7);
+        boolean want;
+        if (bx >= 0 && bx < w && by >= 0 && by < h)
+          want = (rows [by * stride + bx / 8] >> (7 - (bx & 7))) & 1;
+        else if (bx >= 0 && bx < w && by >= h && by < ((h + 7) & ~7))
+          want = false;   // the rest of the last page
+        else
+          want = pixel (before, xx, yy);
+        if (pixel (after, xx, yy) != want)
+          wrong++;
+        }
+    CHECK (wrong == 0, "blitRows (%d x %d at %d,%d): %d pixels wrong", w, h, x, y, wrong);
+    }
+}  // end of testImportRows
+
+int main (int argc, char * argv [])
+{
+  for (int i = 1; i < argc; i++)
+    if (strcmp (argv [i], "--update") == 0)
+      update = true;
+    else
+      goldenDir = argv [i];
+
+  struct { const char * name; void (* run) (); } tests [] = {
+    { "golden images",  testGolden },
+    { "begin",          testBegin },
+    { "rotate 180",     testRotate180 },
+    { "portrait",       testPortrait },
+    { "clear",          testClear },
+    { "bitmap",         testBitmap },
+    { "fillPattern",    testPattern },
+    { "big number",     testBigNumber },
+    { "equivalents",    testEquivalents },
+    { "animation",      testAnimation },
+    { "grayscale",      testGrayscale },
+    { "damage",         testDamage },
+    { "viewports",      testViewports },
+    { "verify",         testVerify },
+    { "autotune",       testAutotune },
+    { "i2c-dev",        testI2cDev },
+    { "strip chart",    testStripChart },
+    { "read back",      testReadBack },
+    { "dither",         testDither },
+    { "importRows",     testImportRows },
+  };
+
+  for (unsigned int i = 0; i < sizeof tests / sizeof tests [0]; i++)
+    {
+    int before = failures;
+    tests [i].run ();
+    printf ("%-16s %s\n", tests [i].name, failures == before ? "ok" : "FAILED");
+    }
+
+  printf ("%d checks, %d failed%s\n", checks, failures, update ? " (golden images written)" : "");
+  return failures ? 1 : 0;
+}  // end of main
@@ -0,0 +1,66 @@
+/*
+ pipeline_test.cpp
+
+ Checks LCD_pipeline (drawing on one thread, sending on another) against LCD_emulator: the LCD
+ ends up showing the last frame submitted. Run it under ThreadSanitizer with "make tsan".
+
+ See I2C_graphical_LCD_display.h for the licence.
+
+ */
+
+#include "I2C_graphical_LCD_display.h"
+#include "host/LCD_emulator.h"
+#include "host/LCD_pipeline.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void drawFrame (I2C_graphical_LCD_display & canvas, const int f)
+{
+  canvas.clear ();
+  canvas.gotoxy (0, 0);
+  canvas.print ("frame ");
+  canvas.print (f);
+  canvas.line (0, 63, 127, (f * 3) % 64, 1);
+}  // end of drawFrame
+
+int main ()
+{
+  LCD_emulator bus;
+  I2C_graphical_LCD_display lcd;
+  lcd.setTransport (bus);
+  lcd.begin ();
+
+  // what the last frame should look like
+  static byte golden [LCD_FRAME_SIZE];
+  I2C_graphical_LCD_display reference;
+  reference.setTarget (golden);
+  const int frames = 200;
+  drawFrame (reference, frames - 1);
+
+  LCD_pipeline pipeline (lcd);
+  pipeline.start ();
+  for (int f = 0; f < frames; f++)
+    {
+    drawFrame (pipeline.canvas (), f);
+    pipeline.submit ();
+    }
+  pipeline.stop ();
+
+  LCD_pipeline::Stats stats = pipeline.stats ();
+  printf ("pipeline: submitted %lu, shown %lu, dropped %lu\n", stats.submitted, stats.shown, stats.dropped);
+
+  int failures = 0;
+  if (stats.submitted != (unsigned long) frames || stats.shown + stats.dropped != stats.submitted)
+    {
+    printf ("  FAIL: frame counts don't add up\n");
+    failures++;
+    }
+  if (bus.compare (golden))
+    {
+    printf ("  FAIL: the LCD doesn't show the last frame (%u bytes differ)\n", bus.compare (golden));
+    failures++;
+    }
+  printf ("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}  // end of main